@@ -63,7 +63,7 @@ def main(shader_dir, output_file):
                         # Some common files might be needed by name, e.g. prepare_dispatch
                         # Keep others as is (though C++ might not load them directly)
                         base = os.path.basename(rel_path)
-                        if base == "prepare_dispatch.wgsl":
+                        if base in ("prepare_dispatch.wgsl", "bin_keypoints.wgsl", "select_keypoints.wgsl"):
                             rel_path = base
                     
                     content = process_includes(filepath)
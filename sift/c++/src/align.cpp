@@ -0,0 +1,224 @@
+#include "align.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <random>
+
+namespace align {
+
+namespace {
+
+// Hartley normalization: translate the centroid to the origin, scale the
+// average distance to sqrt(2). T is the row-major 3x3 transform applied.
+void hartleyNormalize(const std::vector<double>& pts, std::vector<double>* out, double T[9]) {
+    size_t n = pts.size() / 2;
+    double cx = 0, cy = 0;
+    for (size_t i = 0; i < n; ++i) {
+        cx += pts[i * 2];
+        cy += pts[i * 2 + 1];
+    }
+    cx /= n;
+    cy /= n;
+
+    double avg_dist = 0;
+    for (size_t i = 0; i < n; ++i) {
+        double dx = pts[i * 2] - cx;
+        double dy = pts[i * 2 + 1] - cy;
+        avg_dist += std::sqrt(dx * dx + dy * dy);
+    }
+    avg_dist /= n;
+    double scale = avg_dist > 1e-12 ? std::sqrt(2.0) / avg_dist : 1.0;
+
+    T[0] = scale; T[1] = 0;     T[2] = -scale * cx;
+    T[3] = 0;     T[4] = scale; T[5] = -scale * cy;
+    T[6] = 0;     T[7] = 0;     T[8] = 1;
+
+    out->resize(n * 2);
+    for (size_t i = 0; i < n; ++i) {
+        (*out)[i * 2] = scale * (pts[i * 2] - cx);
+        (*out)[i * 2 + 1] = scale * (pts[i * 2 + 1] - cy);
+    }
+}
+
+// Cyclic Jacobi eigen decomposition of a symmetric 9x9 matrix; same role as
+// JacobiEigenvalue.compute in the JS geometry code. Eigenvectors land in the
+// rows of v.
+void jacobiEigen9(double a[9][9], double v[9][9], double w[9]) {
+    for (int i = 0; i < 9; ++i) {
+        for (int j = 0; j < 9; ++j) v[i][j] = i == j ? 1.0 : 0.0;
+    }
+    for (int sweep = 0; sweep < 100; ++sweep) {
+        double off = 0;
+        for (int p = 0; p < 9; ++p) {
+            for (int q = p + 1; q < 9; ++q) off += a[p][q] * a[p][q];
+        }
+        if (off < 1e-24) break;
+
+        for (int p = 0; p < 9; ++p) {
+            for (int q = p + 1; q < 9; ++q) {
+                if (std::abs(a[p][q]) < 1e-18) continue;
+                double theta = (a[q][q] - a[p][p]) / (2.0 * a[p][q]);
+                double t = (theta >= 0 ? 1.0 : -1.0) /
+                           (std::abs(theta) + std::sqrt(theta * theta + 1.0));
+                double c = 1.0 / std::sqrt(t * t + 1.0);
+                double s = t * c;
+
+                for (int k = 0; k < 9; ++k) {
+                    double akp = a[k][p], akq = a[k][q];
+                    a[k][p] = c * akp - s * akq;
+                    a[k][q] = s * akp + c * akq;
+                }
+                for (int k = 0; k < 9; ++k) {
+                    double apk = a[p][k], aqk = a[q][k];
+                    a[p][k] = c * apk - s * aqk;
+                    a[q][k] = s * apk + c * aqk;
+                }
+                for (int k = 0; k < 9; ++k) {
+                    double vpk = v[p][k], vqk = v[q][k];
+                    v[p][k] = c * vpk - s * vqk;
+                    v[q][k] = s * vpk + c * vqk;
+                }
+            }
+        }
+    }
+    for (int i = 0; i < 9; ++i) w[i] = a[i][i];
+}
+
+// Row-major 3x3 product: out = a * b
+void mul3x3(const double a[9], const double b[9], double out[9]) {
+    for (int i = 0; i < 3; ++i) {
+        for (int j = 0; j < 3; ++j) {
+            out[i * 3 + j] = a[i * 3] * b[j] + a[i * 3 + 1] * b[3 + j] + a[i * 3 + 2] * b[6 + j];
+        }
+    }
+}
+
+}  // namespace
+
+bool computeHomography(const std::vector<double>& pts1,
+                       const std::vector<double>& pts2,
+                       Homography* H) {
+    size_t n = pts1.size() / 2;
+    if (n < 4 || pts2.size() != pts1.size()) return false;
+
+    std::vector<double> norm1, norm2;
+    double T1[9], T2[9];
+    hartleyNormalize(pts1, &norm1, T1);
+    hartleyNormalize(pts2, &norm2, T2);
+
+    // Accumulate A^T A directly from the two DLT constraint rows per
+    // correspondence instead of materializing A (2n x 9).
+    double ata[9][9];
+    std::memset(ata, 0, sizeof(ata));
+    for (size_t i = 0; i < n; ++i) {
+        double x = norm1[i * 2], y = norm1[i * 2 + 1];
+        double xp = norm2[i * 2], yp = norm2[i * 2 + 1];
+        double r1[9] = {-x, -y, -1, 0, 0, 0, x * xp, y * xp, xp};
+        double r2[9] = {0, 0, 0, -x, -y, -1, x * yp, y * yp, yp};
+        for (int a = 0; a < 9; ++a) {
+            for (int b = a; b < 9; ++b) {
+                ata[a][b] += r1[a] * r1[b] + r2[a] * r2[b];
+            }
+        }
+    }
+    for (int a = 0; a < 9; ++a) {
+        for (int b = 0; b < a; ++b) ata[a][b] = ata[b][a];
+    }
+
+    double vecs[9][9], vals[9];
+    jacobiEigen9(ata, vecs, vals);
+
+    int min_idx = 0;
+    for (int i = 1; i < 9; ++i) {
+        if (std::abs(vals[i]) < std::abs(vals[min_idx])) min_idx = i;
+    }
+    const double* h = vecs[min_idx];
+
+    // Denormalize: H = T2^-1 * H_norm * T1
+    double t2inv[9] = {
+        1.0 / T2[0], 0, -T2[2] / T2[0],
+        0, 1.0 / T2[4], -T2[5] / T2[4],
+        0, 0, 1
+    };
+    double hn[9];
+    std::memcpy(hn, h, sizeof(hn));
+    double tmp[9];
+    mul3x3(t2inv, hn, tmp);
+    mul3x3(tmp, T1, H->m);
+
+    if (std::abs(H->m[8]) < 1e-10) return false;
+    double s = 1.0 / H->m[8];
+    for (int i = 0; i < 9; ++i) H->m[i] *= s;
+    return true;
+}
+
+RansacResult estimateHomographyRANSAC(const std::vector<double>& pts1,
+                                      const std::vector<double>& pts2,
+                                      double threshold,
+                                      int max_iterations,
+                                      double confidence) {
+    RansacResult result;
+    size_t n = pts1.size() / 2;
+    if (n < 4 || pts2.size() != pts1.size()) return result;
+
+    double threshold_sq = threshold * threshold;
+    std::mt19937 rng(0x5EED);  // Deterministic runs diff cleanly across jobs
+    std::uniform_int_distribution<size_t> pick(0, n - 1);
+
+    int iterations = max_iterations;
+    std::vector<double> sample1(8), sample2(8);
+    std::vector<int> inliers;
+
+    for (int iter = 0; iter < iterations; ++iter) {
+        size_t idx[4];
+        for (int k = 0; k < 4; ++k) {
+            for (;;) {
+                idx[k] = pick(rng);
+                bool dup = false;
+                for (int j = 0; j < k; ++j) dup = dup || idx[j] == idx[k];
+                if (!dup) break;
+            }
+        }
+        for (int k = 0; k < 4; ++k) {
+            sample1[k * 2] = pts1[idx[k] * 2];
+            sample1[k * 2 + 1] = pts1[idx[k] * 2 + 1];
+            sample2[k * 2] = pts2[idx[k] * 2];
+            sample2[k * 2 + 1] = pts2[idx[k] * 2 + 1];
+        }
+
+        Homography H;
+        if (!computeHomography(sample1, sample2, &H)) continue;
+
+        // Forward transfer error only, same as the JS estimatePixels path
+        inliers.clear();
+        for (size_t i = 0; i < n; ++i) {
+            double x1 = pts1[i * 2], y1 = pts1[i * 2 + 1];
+            double w = H.m[6] * x1 + H.m[7] * y1 + H.m[8];
+            if (std::abs(w) < 1e-10) continue;
+            double x2e = (H.m[0] * x1 + H.m[1] * y1 + H.m[2]) / w;
+            double y2e = (H.m[3] * x1 + H.m[4] * y1 + H.m[5]) / w;
+            double dx = pts2[i * 2] - x2e;
+            double dy = pts2[i * 2 + 1] - y2e;
+            if (dx * dx + dy * dy < threshold_sq) inliers.push_back((int)i);
+        }
+
+        if (inliers.size() > result.inliers.size()) {
+            result.H = H;
+            result.inliers = inliers;
+            result.ok = true;
+
+            double ratio = (double)inliers.size() / n;
+            if (ratio > 0.1) {
+                double denom = std::log(1.0 - std::pow(ratio, 4.0));
+                if (denom < 0) {
+                    int needed = (int)std::ceil(std::log(1.0 - confidence) / denom);
+                    iterations = std::min(max_iterations, std::max(iter + 1, needed));
+                }
+            }
+        }
+    }
+    return result;
+}
+
+}  // namespace align
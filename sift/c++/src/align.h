@@ -0,0 +1,41 @@
+#ifndef WEBSIFTGPU_CPP_SRC_ALIGN_H_
+#define WEBSIFTGPU_CPP_SRC_ALIGN_H_
+
+#include <vector>
+
+// Homography estimation for frame-set alignment, mirroring the JS
+// implementation (src/geometry/homography_matrix.js): normalized DLT
+// 4-point solve with Hartley normalization, RANSAC with forward transfer
+// error and an adaptive iteration count.
+
+namespace align {
+
+// Row-major 3x3 homography; maps image-1 points onto image-2.
+struct Homography {
+    double m[9] = {1, 0, 0, 0, 1, 0, 0, 0, 1};
+};
+
+struct RansacResult {
+    Homography H;
+    std::vector<int> inliers;  // Indices into the correspondence arrays
+    bool ok = false;
+};
+
+// Normalized DLT from >= 4 correspondences. Points are flattened
+// [x0, y0, x1, y1, ...], same convention as SIFTMatcher::MatchGuided.
+// Returns false on degenerate input.
+bool computeHomography(const std::vector<double>& pts1,
+                       const std::vector<double>& pts2,
+                       Homography* H);
+
+// RANSAC estimate of H such that H * pts1 ~ pts2. threshold is the forward
+// transfer error in pixels; iterations adapt to the observed inlier ratio.
+RansacResult estimateHomographyRANSAC(const std::vector<double>& pts1,
+                                      const std::vector<double>& pts2,
+                                      double threshold = 5.0,
+                                      int max_iterations = 1000,
+                                      double confidence = 0.99);
+
+}  // namespace align
+
+#endif  // WEBSIFTGPU_CPP_SRC_ALIGN_H_
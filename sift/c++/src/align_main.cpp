@@ -0,0 +1,233 @@
+// websiftgpu_align: end-to-end wigglegram alignment in one process.
+//
+// Takes N frames, detects SIFT keypoints with the packed GPU engine, matches
+// every frame against a reference frame, estimates a homography per pair with
+// RANSAC (align.h) and emits the transforms as JSON. The stages are
+// pipelined: files decode on a thread pool ahead of the consumer
+// (utils::ImageBatchLoader), detection runs with two frames in flight
+// (SubmitFrame), matching of completed frames is issued while later
+// detections are still on the GPU, and RANSAC runs on its own worker thread
+// behind the matcher.
+
+#include <condition_variable>
+#include <deque>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <webgpu/webgpu.hpp>
+
+#include "align.h"
+#include "sift_matcher.h"
+#include "sift_packed.h"
+#include "utils.h"
+
+// Same device bring-up as main.cpp
+static wgpu::Device CreateDevice() {
+    wgpu::Instance instance = wgpu::createInstance();
+    if (!instance) {
+        std::cerr << "Failed to create WebGPU instance." << std::endl;
+        exit(1);
+    }
+
+    wgpu::RequestAdapterOptions adapterOptions = {};
+    adapterOptions.powerPreference = wgpu::PowerPreference::HighPerformance;
+    wgpu::Adapter adapter = instance.requestAdapter(adapterOptions);
+    if (!adapter) {
+        std::cerr << "Adapter request failed." << std::endl;
+        exit(1);
+    }
+
+    wgpu::DeviceDescriptor deviceDesc = {};
+    deviceDesc.label = wgpu::StringView("WebSIFTGPU Align Device");
+    std::vector<wgpu::FeatureName> requiredFeatures;
+    requiredFeatures.push_back(wgpu::FeatureName::TimestampQuery);
+    deviceDesc.requiredFeatures = (const WGPUFeatureName*)requiredFeatures.data();
+    deviceDesc.requiredFeatureCount = requiredFeatures.size();
+    deviceDesc.uncapturedErrorCallbackInfo.callback =
+        [](const WGPUDevice*, WGPUErrorType type, WGPUStringView message, void*, void*) {
+            std::cerr << "Uncaptured WebGPU Error (" << type << "): ";
+            if (message.data) std::cerr << std::string(message.data, message.length);
+            std::cerr << std::endl;
+        };
+
+    wgpu::Device device = adapter.requestDevice(deviceDesc);
+    if (!device) {
+        std::cerr << "Device request failed." << std::endl;
+        exit(1);
+    }
+    return device;
+}
+
+namespace {
+
+struct FrameData {
+    std::string path;
+    bool decoded = false;
+    bool detected = false;
+    bool matched = false;
+    std::vector<Keypoint> keypoints;
+    std::vector<float> descriptors;
+};
+
+struct PairJob {
+    int index;
+    size_t match_count;
+    std::vector<double> pts1;  // Frame keypoints
+    std::vector<double> pts2;  // Reference keypoints
+};
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    int ref = 0;
+    std::string out_path;
+    float ratio = 0.75f;
+    double threshold = 5.0;
+    bool gray = false;
+    std::vector<std::string> paths;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--ref" && i + 1 < argc) ref = std::atoi(argv[++i]);
+        else if (arg == "--out" && i + 1 < argc) out_path = argv[++i];
+        else if (arg == "--ratio" && i + 1 < argc) ratio = (float)std::atof(argv[++i]);
+        else if (arg == "--threshold" && i + 1 < argc) threshold = std::atof(argv[++i]);
+        else if (arg == "--gray") gray = true;
+        else paths.push_back(arg);
+    }
+
+    int n = (int)paths.size();
+    if (n < 2 || ref < 0 || ref >= n) {
+        std::cout << "Usage: " << argv[0]
+                  << " <frame0> <frame1> ... [--ref N] [--out file] [--ratio R] [--threshold px] [--gray]"
+                  << std::endl;
+        return 1;
+    }
+
+    wgpu::Device device = CreateDevice();
+    SIFTOptions options;
+    options.grayscaleInput = gray;
+    SIFTPacked sift;
+    sift.Init(device, options);
+    SIFTMatcher matcher;
+    matcher.Init(device);
+
+    std::vector<FrameData> frames(n);
+    std::vector<align::RansacResult> models(n);
+    std::vector<size_t> match_counts(n, 0);
+
+    // RANSAC worker: model estimation is host-side and independent per pair,
+    // so it runs behind the matcher instead of serializing with it.
+    std::deque<PairJob> jobs;
+    std::mutex jobs_mutex;
+    std::condition_variable jobs_cv;
+    bool jobs_closed = false;
+    std::thread ransac_worker([&] {
+        for (;;) {
+            PairJob job;
+            {
+                std::unique_lock<std::mutex> lock(jobs_mutex);
+                jobs_cv.wait(lock, [&] { return jobs_closed || !jobs.empty(); });
+                if (jobs.empty()) return;
+                job = std::move(jobs.front());
+                jobs.pop_front();
+            }
+            models[job.index] = align::estimateHomographyRANSAC(job.pts1, job.pts2, threshold);
+            match_counts[job.index] = job.match_count;
+        }
+    });
+
+    // Matches frame i against the reference once both detections have landed,
+    // and hands the correspondences to the RANSAC worker.
+    auto try_match = [&](int i) {
+        if (frames[i].matched || !frames[i].detected || !frames[ref].detected) return;
+        frames[i].matched = true;
+        if (i == ref) return;
+
+        std::vector<Match> matches = matcher.MatchDescriptors(
+            frames[i].descriptors, frames[ref].descriptors, ratio);
+
+        PairJob job;
+        job.index = i;
+        job.match_count = matches.size();
+        job.pts1.reserve(matches.size() * 2);
+        job.pts2.reserve(matches.size() * 2);
+        for (const Match& m : matches) {
+            const Keypoint& ka = frames[i].keypoints[m.queryIdx];
+            const Keypoint& kb = frames[ref].keypoints[m.trainIdx];
+            job.pts1.push_back(ka.x); job.pts1.push_back(ka.y);
+            job.pts2.push_back(kb.x); job.pts2.push_back(kb.y);
+        }
+        {
+            std::lock_guard<std::mutex> lock(jobs_mutex);
+            jobs.push_back(std::move(job));
+        }
+        jobs_cv.notify_one();
+    };
+
+    // Decode runs ahead on the loader's pool; detection keeps two frames in
+    // flight; completed frames are matched while later detections are still
+    // on the GPU (queue order puts the matcher behind them, and the host
+    // blocks on the matcher readback, not on detection).
+    utils::ImageBatchLoader loader(paths, gray ? 1 : 4);
+    utils::LoadedImage img;
+    int index = 0;
+    while (loader.next(img)) {
+        int i = index++;
+        frames[i].path = img.path;
+        if (!img.ok) continue;
+        frames[i].decoded = true;
+        sift.SubmitFrame(img.pixels, img.width, img.height, (uint64_t)i,
+                         [&frames, i](FrameResult result) {
+                             frames[i].keypoints = std::move(result.keypoints);
+                             frames[i].descriptors = std::move(result.descriptors);
+                             frames[i].detected = true;
+                         });
+        for (int j = 0; j <= i; ++j) try_match(j);
+    }
+    sift.WaitIdle();
+    for (int j = 0; j < n; ++j) {
+        if (frames[j].decoded) try_match(j);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(jobs_mutex);
+        jobs_closed = true;
+    }
+    jobs_cv.notify_all();
+    ransac_worker.join();
+
+    std::ofstream file;
+    if (!out_path.empty()) file.open(out_path);
+    std::ostream& out = out_path.empty() ? std::cout : file;
+
+    out << "{\n  \"reference\": " << ref << ",\n  \"frames\": [\n";
+    const align::Homography identity;
+    for (int i = 0; i < n; ++i) {
+        const align::RansacResult& r = models[i];
+        bool ok = i == ref ? frames[i].decoded : r.ok;
+        out << "    { \"path\": \"" << frames[i].path << "\""
+            << ", \"keypoints\": " << frames[i].keypoints.size()
+            << ", \"matches\": " << match_counts[i]
+            << ", \"inliers\": " << r.inliers.size()
+            << ", \"ok\": " << (ok ? "true" : "false")
+            << ", \"H\": [";
+        const double* H = i == ref ? identity.m : r.H.m;
+        for (int k = 0; k < 9; ++k) out << H[k] << (k < 8 ? "," : "");
+        out << "] }" << (i < n - 1 ? "," : "") << "\n";
+    }
+    out << "  ]\n}\n";
+
+    for (int i = 0; i < n; ++i) {
+        if (frames[i].decoded && i != ref && !models[i].ok) {
+            std::cerr << "[websiftgpu_align] No model for frame " << i
+                      << " (" << frames[i].path << "), " << match_counts[i]
+                      << " matches" << std::endl;
+        }
+    }
+    return 0;
+}
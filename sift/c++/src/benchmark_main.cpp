@@ -1,15 +1,30 @@
+// websiftgpu_bench: regression benchmark suite.
+//
+// Covers detection across a resolution sweep (VGA to 4K, synthetic frames if
+// no input image is given), the matcher across a descriptor-count grid
+// (MatchDescriptors brute-force and MatchGuided), and a keypoint-density
+// stress case. Results go to stdout or --out as CSV or JSON with
+// percentiles; --baseline compares against a previous CSV run and exits
+// nonzero when any timing metric regresses beyond --threshold, so CI can
+// gate perf changes instead of eyeballing stdout diffs.
+
 #include <iostream>
+#include <fstream>
+#include <map>
+#include <random>
+#include <sstream>
 #include <vector>
 #include <string>
 #include <numeric>
 #include <algorithm>
-#include <iomanip>
+#include <cmath>
 #include "absl/time/time.h"
 #include "absl/time/clock.h"
 
 #include <webgpu/webgpu.hpp>
 #include <webgpu/webgpu.h>
 #include "sift_packed.h"
+#include "sift_matcher.h"
 #include "utils.h"
 
 // wgpu-native extension function
@@ -32,74 +47,374 @@ wgpu::Device CreateDevice() {
     return device;
 }
 
-struct PerfStats {
-    std::string name;
-    std::vector<double> times;
-    void print() {
-        if (times.empty()) return;
-        double sum = std::accumulate(times.begin(), times.end(), 0.0);
-        double mean = sum / times.size();
-        std::sort(times.begin(), times.end());
-        double median = times[times.size() / 2];
-        std::cout << std::left << std::setw(15) << name << ": Mean=" << std::fixed << std::setprecision(2) << mean 
-                  << "ms, Median=" << median << "ms, Min=" << times.front() << "ms, Max=" << times.back() << "ms" << std::endl;
-    }
+namespace {
+
+// One metric of one benchmark case (e.g. case "detect_1920x1080_f32",
+// metric "host_ms"), holding every iteration's sample.
+struct BenchRow {
+    std::string bench_case;
+    std::string metric;
+    std::vector<double> samples;
+};
+
+double Percentile(std::vector<double> sorted, double p) {
+    if (sorted.empty()) return 0;
+    size_t idx = (size_t)std::ceil(p / 100.0 * sorted.size());
+    if (idx > 0) idx--;
+    return sorted[std::min(idx, sorted.size() - 1)];
+}
+
+struct RowStats {
+    size_t count;
+    double mean, p50, p90, p99, min, max;
 };
 
-void RunBenchmark(wgpu::Device device, const std::vector<uint8_t>& image_data, int width, int height, bool quantize) {
+RowStats ComputeStats(const BenchRow& row) {
+    RowStats s = {};
+    if (row.samples.empty()) return s;
+    std::vector<double> sorted = row.samples;
+    std::sort(sorted.begin(), sorted.end());
+    s.count = sorted.size();
+    s.mean = std::accumulate(sorted.begin(), sorted.end(), 0.0) / sorted.size();
+    s.p50 = Percentile(sorted, 50);
+    s.p90 = Percentile(sorted, 90);
+    s.p99 = Percentile(sorted, 99);
+    s.min = sorted.front();
+    s.max = sorted.back();
+    return s;
+}
+
+// Synthetic RGBA frame: low-frequency sinusoid blobs (stable structure that
+// produces a realistic keypoint count) blended with deterministic hash
+// noise. noise_amp ~1 drowns the structure in per-pixel noise, which
+// maximizes DoG extrema — the keypoint-density stress case.
+std::vector<uint8_t> SyntheticImage(int w, int h, float noise_amp) {
+    std::vector<uint8_t> img((size_t)w * h * 4);
+    for (int y = 0; y < h; ++y) {
+        for (int x = 0; x < w; ++x) {
+            float v = 0.5f
+                + 0.20f * std::sin(x * 0.031f) * std::cos(y * 0.043f)
+                + 0.15f * std::sin((x + y) * 0.011f)
+                + 0.10f * std::cos(x * 0.0021f * y * 0.0017f);
+            uint32_t hash = (uint32_t)(x * 374761393u + y * 668265263u);
+            hash = (hash ^ (hash >> 13)) * 1274126177u;
+            v += noise_amp * (((hash >> 8) & 0xFFFF) / 65535.0f - 0.5f);
+            uint8_t g = (uint8_t)std::max(0.0f, std::min(255.0f, v * 255.0f));
+            size_t i = ((size_t)y * w + x) * 4;
+            img[i] = img[i + 1] = img[i + 2] = g;
+            img[i + 3] = 255;
+        }
+    }
+    return img;
+}
+
+// Nearest-neighbor resample of a loaded image to a sweep resolution; good
+// enough for benchmarking (the content statistics are what matter).
+std::vector<uint8_t> ResizeImage(const std::vector<uint8_t>& src, int sw, int sh, int dw, int dh) {
+    std::vector<uint8_t> dst((size_t)dw * dh * 4);
+    for (int y = 0; y < dh; ++y) {
+        int sy = (int)((int64_t)y * sh / dh);
+        for (int x = 0; x < dw; ++x) {
+            int sx = (int)((int64_t)x * sw / dw);
+            size_t si = ((size_t)sy * sw + sx) * 4;
+            size_t di = ((size_t)y * dw + x) * 4;
+            for (int c = 0; c < 4; ++c) dst[di + c] = src[si + c];
+        }
+    }
+    return dst;
+}
+
+// Random unit-normalized float descriptors, deterministic across runs so a
+// baseline and a candidate build benchmark identical workloads.
+std::vector<float> RandomDescriptors(int count, uint32_t seed) {
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<float> dist(0.0f, 1.0f);
+    std::vector<float> desc((size_t)count * 128);
+    for (int i = 0; i < count; ++i) {
+        float norm = 0;
+        for (int k = 0; k < 128; ++k) {
+            float v = dist(rng);
+            desc[(size_t)i * 128 + k] = v;
+            norm += v * v;
+        }
+        norm = std::sqrt(norm) + 1e-6f;
+        for (int k = 0; k < 128; ++k) desc[(size_t)i * 128 + k] /= norm;
+    }
+    return desc;
+}
+
+std::vector<float> RandomPoints(int count, uint32_t seed) {
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<float> dist(0.0f, 2000.0f);
+    std::vector<float> pts((size_t)count * 2);
+    for (float& p : pts) p = dist(rng);
+    return pts;
+}
+
+void RunDetectCase(wgpu::Device device, const std::string& name,
+                   const std::vector<uint8_t>& image, int width, int height,
+                   bool quantize, int iterations, std::vector<BenchRow>& rows) {
     SIFTOptions options;
     options.quantizeDescriptors = quantize;
     SIFTPacked sift;
     sift.Init(device, options);
 
-    std::cout << "\n>>> Benchmarking " << (quantize ? "QUANTIZED" : "FLOAT32") << " (" << width << "x" << height << ")..." << std::endl;
-    std::cout << "Warming up..." << std::flush;
-    
-    // Warmup
-    sift.DetectKeypoints(image_data.data(), width, height);
-    std::cout << " done" << std::endl;
-    
-    int iterations = 30;
-    std::vector<PerfStats> stats = {
-        {"Grayscale", {}}, {"Pyramids", {}}, {"Extrema", {}}, {"Orientation", {}}, {"Descriptor", {}}, {"Download", {}}, {"Total (GPU)", {}}, {"Host Total", {}}
-    };
+    std::cerr << ">>> " << name << " ..." << std::flush;
+    sift.DetectKeypoints(image.data(), width, height); // Warmup
+
+    BenchRow host = {name, "host_ms", {}};
+    BenchRow gpu = {name, "gpu_total_ms", {}};
+    BenchRow pyramids = {name, "pyramids_ms", {}};
+    BenchRow extrema = {name, "extrema_ms", {}};
+    BenchRow orientation = {name, "orientation_ms", {}};
+    BenchRow descriptor = {name, "descriptor_ms", {}};
+    BenchRow download = {name, "download_ms", {}};
 
     for (int i = 0; i < iterations; ++i) {
         auto t0 = absl::Now();
-        sift.DetectKeypoints(image_data.data(), width, height);
+        sift.DetectKeypoints(image.data(), width, height);
         auto t1 = absl::Now();
-        double host_ms = absl::ToDoubleMilliseconds(t1 - t0);
+        host.samples.push_back(absl::ToDoubleMilliseconds(t1 - t0));
 
         const auto& prof = sift.GetProfiling();
-        stats[0].times.push_back(prof.grayscale_ms);
-        stats[1].times.push_back(prof.pyramids_ms);
-        stats[2].times.push_back(prof.extrema_ms);
-        stats[3].times.push_back(prof.orientation_ms);
-        stats[4].times.push_back(prof.descriptor_ms);
-        stats[5].times.push_back(prof.download_ms);
-        stats[6].times.push_back(prof.total_ms);
-        stats[7].times.push_back(host_ms);
-    }
-
-    for (auto& s : stats) s.print();
-    std::cout << "Detected " << sift.GetKeypointsCount() << " keypoints." << std::endl;
+        gpu.samples.push_back(prof.total_ms);
+        pyramids.samples.push_back(prof.pyramids_ms);
+        extrema.samples.push_back(prof.extrema_ms);
+        orientation.samples.push_back(prof.orientation_ms);
+        descriptor.samples.push_back(prof.descriptor_ms);
+        download.samples.push_back(prof.download_ms);
+    }
+
+    // Counts ride along as (degenerate) rows so the output records the
+    // workload, but only *_ms metrics take part in regression checks.
+    BenchRow keypoints = {name, "keypoints", {(double)sift.GetKeypointsCount()}};
+    rows.push_back(host);
+    rows.push_back(gpu);
+    rows.push_back(pyramids);
+    rows.push_back(extrema);
+    rows.push_back(orientation);
+    rows.push_back(descriptor);
+    rows.push_back(download);
+    rows.push_back(keypoints);
+    std::cerr << " " << sift.GetKeypointsCount() << " keypoints, host p50="
+              << ComputeStats(host).p50 << "ms" << std::endl;
+    if (sift.GetProfiling().keypoint_overflow) {
+        std::cerr << "    (keypoint buffer saturated)" << std::endl;
+    }
+}
+
+void RunMatchCases(wgpu::Device device, int iterations, std::vector<BenchRow>& rows) {
+    SIFTMatcher matcher;
+    matcher.Init(device);
+
+    const int grid[] = {1000, 5000, 20000};
+    for (int countA : grid) {
+        for (int countB : grid) {
+            std::vector<float> descA = RandomDescriptors(countA, 1);
+            std::vector<float> descB = RandomDescriptors(countB, 2);
+            std::string name = "match_" + std::to_string(countA) + "x" + std::to_string(countB);
+            std::cerr << ">>> " << name << " ..." << std::flush;
+
+            matcher.MatchDescriptors(descA, descB); // Warmup
+            BenchRow host = {name, "host_ms", {}};
+            for (int i = 0; i < iterations; ++i) {
+                auto t0 = absl::Now();
+                matcher.MatchDescriptors(descA, descB);
+                auto t1 = absl::Now();
+                host.samples.push_back(absl::ToDoubleMilliseconds(t1 - t0));
+            }
+            rows.push_back(host);
+            std::cerr << " p50=" << ComputeStats(host).p50 << "ms" << std::endl;
+        }
+    }
+
+    // Guided matching: one mid-grid pair with a fixed F and a loose epipolar
+    // threshold (perf does not depend on the geometry being meaningful).
+    {
+        int count = 5000;
+        std::vector<float> descA = RandomDescriptors(count, 1);
+        std::vector<float> descB = RandomDescriptors(count, 2);
+        std::vector<float> kpsA = RandomPoints(count, 3);
+        std::vector<float> kpsB = RandomPoints(count, 4);
+        std::vector<float> F = {0, -1e-6f, 1e-3f, 1e-6f, 0, -1e-3f, -1e-3f, 1e-3f, 1};
+        std::string name = "match_guided_" + std::to_string(count) + "x" + std::to_string(count);
+        std::cerr << ">>> " << name << " ..." << std::flush;
+
+        matcher.MatchGuided(descA, kpsA, descB, kpsB, F, 50.0f); // Warmup
+        BenchRow host = {name, "host_ms", {}};
+        for (int i = 0; i < iterations; ++i) {
+            auto t0 = absl::Now();
+            matcher.MatchGuided(descA, kpsA, descB, kpsB, F, 50.0f);
+            auto t1 = absl::Now();
+            host.samples.push_back(absl::ToDoubleMilliseconds(t1 - t0));
+        }
+        rows.push_back(host);
+        std::cerr << " p50=" << ComputeStats(host).p50 << "ms" << std::endl;
+    }
+}
+
+void WriteCsv(std::ostream& out, const std::vector<BenchRow>& rows) {
+    out << "case,metric,samples,mean_ms,p50_ms,p90_ms,p99_ms,min_ms,max_ms\n";
+    for (const BenchRow& row : rows) {
+        RowStats s = ComputeStats(row);
+        out << row.bench_case << "," << row.metric << "," << s.count << ","
+            << s.mean << "," << s.p50 << "," << s.p90 << "," << s.p99 << ","
+            << s.min << "," << s.max << "\n";
+    }
 }
 
+void WriteJson(std::ostream& out, const std::vector<BenchRow>& rows) {
+    out << "[\n";
+    for (size_t i = 0; i < rows.size(); ++i) {
+        RowStats s = ComputeStats(rows[i]);
+        out << "  { \"case\": \"" << rows[i].bench_case << "\""
+            << ", \"metric\": \"" << rows[i].metric << "\""
+            << ", \"samples\": " << s.count
+            << ", \"mean_ms\": " << s.mean
+            << ", \"p50_ms\": " << s.p50
+            << ", \"p90_ms\": " << s.p90
+            << ", \"p99_ms\": " << s.p99
+            << ", \"min_ms\": " << s.min
+            << ", \"max_ms\": " << s.max
+            << " }" << (i < rows.size() - 1 ? "," : "") << "\n";
+    }
+    out << "]\n";
+}
+
+// Loads case/metric -> p50 from a CSV written by this tool.
+bool LoadBaseline(const std::string& path, std::map<std::string, double>& out) {
+    std::ifstream file(path);
+    if (!file) return false;
+    std::string line;
+    std::getline(file, line); // Header
+    while (std::getline(file, line)) {
+        std::stringstream ss(line);
+        std::string bench_case, metric, field;
+        std::getline(ss, bench_case, ',');
+        std::getline(ss, metric, ',');
+        std::getline(ss, field, ','); // samples
+        std::getline(ss, field, ','); // mean
+        std::getline(ss, field, ','); // p50
+        if (bench_case.empty() || metric.empty() || field.empty()) continue;
+        out[bench_case + "/" + metric] = std::atof(field.c_str());
+    }
+    return true;
+}
+
+// Compares p50 against the baseline; returns the number of timing metrics
+// that regressed beyond the threshold fraction. New or removed cases are
+// reported but never fail the run.
+int CompareBaseline(const std::vector<BenchRow>& rows,
+                    const std::map<std::string, double>& baseline,
+                    double threshold) {
+    int regressions = 0;
+    for (const BenchRow& row : rows) {
+        if (row.metric.size() < 3 || row.metric.substr(row.metric.size() - 3) != "_ms") continue;
+        std::string key = row.bench_case + "/" + row.metric;
+        auto it = baseline.find(key);
+        if (it == baseline.end()) {
+            std::cerr << "[bench] " << key << ": not in baseline, skipping" << std::endl;
+            continue;
+        }
+        double p50 = ComputeStats(row).p50;
+        double base = it->second;
+        double delta = base > 0 ? (p50 - base) / base : 0;
+        if (delta > threshold) {
+            std::cerr << "[bench] REGRESSION " << key << ": " << base << "ms -> " << p50
+                      << "ms (+" << (int)(delta * 100) << "%)" << std::endl;
+            regressions++;
+        } else if (delta < -threshold) {
+            std::cerr << "[bench] improvement " << key << ": " << base << "ms -> " << p50
+                      << "ms (" << (int)(delta * 100) << "%)" << std::endl;
+        }
+    }
+    return regressions;
+}
+
+}  // namespace
+
 int main(int argc, char* argv[]) {
-    if (argc < 2) {
-        std::cerr << "Usage: " << argv[0] << " <image_path>" << std::endl;
+    std::string image_path, out_path, format = "csv", baseline_path;
+    double threshold = 0.10;
+    int iterations = 30;
+    int match_iterations = 10;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--out" && i + 1 < argc) out_path = argv[++i];
+        else if (arg == "--format" && i + 1 < argc) format = argv[++i];
+        else if (arg == "--baseline" && i + 1 < argc) baseline_path = argv[++i];
+        else if (arg == "--threshold" && i + 1 < argc) threshold = std::atof(argv[++i]);
+        else if (arg == "--iterations" && i + 1 < argc) iterations = std::atoi(argv[++i]);
+        else if (arg == "--help") {
+            std::cout << "Usage: " << argv[0]
+                      << " [image] [--iterations N] [--out file] [--format csv|json]"
+                      << " [--baseline results.csv] [--threshold frac]" << std::endl;
+            return 0;
+        }
+        else image_path = arg;
+    }
+    if (format != "csv" && format != "json") {
+        std::cerr << "Unknown format: " << format << std::endl;
         return 1;
     }
 
-    int width, height;
-    std::vector<uint8_t> image_data = utils::loadImage(argv[1], &width, &height);
-    if (image_data.empty()) return 1;
+    // Optional real image; each sweep resolution resamples it. Without one,
+    // the sweep runs on the synthetic frames (fully deterministic, so
+    // baseline comparisons need no test asset).
+    int src_w = 0, src_h = 0;
+    std::vector<uint8_t> src_image;
+    if (!image_path.empty()) {
+        src_image = utils::loadImage(image_path, &src_w, &src_h);
+        if (src_image.empty()) return 1;
+    }
 
     wgpu::Device device = CreateDevice();
-    
+    std::vector<BenchRow> rows;
 
-    RunBenchmark(device, image_data, width, height, false);
-    RunBenchmark(device, image_data, width, height, true);
+    // Resolution sweep, float32 and quantized descriptors.
+    const std::pair<int, int> sweep[] = {
+        {640, 480}, {1280, 720}, {1920, 1080}, {2560, 1440}, {3840, 2160}
+    };
+    for (const auto& size : sweep) {
+        int w = size.first, h = size.second;
+        std::vector<uint8_t> image = src_image.empty()
+            ? SyntheticImage(w, h, 0.05f)
+            : ResizeImage(src_image, src_w, src_h, w, h);
+        std::string res = std::to_string(w) + "x" + std::to_string(h);
+        RunDetectCase(device, "detect_" + res + "_f32", image, w, h, false, iterations, rows);
+        RunDetectCase(device, "detect_" + res + "_quant", image, w, h, true, iterations, rows);
+    }
+
+    // Keypoint-density stress: near-pure noise maximizes DoG extrema and
+    // exercises the saturation/selection paths.
+    {
+        int w = 1920, h = 1080;
+        std::vector<uint8_t> image = SyntheticImage(w, h, 0.9f);
+        RunDetectCase(device, "detect_stress_1080p", image, w, h, false, iterations, rows);
+    }
 
+    RunMatchCases(device, match_iterations, rows);
+
+    std::ofstream file;
+    if (!out_path.empty()) file.open(out_path);
+    std::ostream& out = out_path.empty() ? std::cout : file;
+    if (format == "json") WriteJson(out, rows);
+    else WriteCsv(out, rows);
+
+    if (!baseline_path.empty()) {
+        std::map<std::string, double> baseline;
+        if (!LoadBaseline(baseline_path, baseline)) {
+            std::cerr << "Failed to load baseline: " << baseline_path << std::endl;
+            return 1;
+        }
+        int regressions = CompareBaseline(rows, baseline, threshold);
+        if (regressions > 0) {
+            std::cerr << regressions << " metric(s) regressed beyond "
+                      << (int)(threshold * 100) << "%" << std::endl;
+            return 2;
+        }
+        std::cerr << "No regressions beyond " << (int)(threshold * 100) << "%" << std::endl;
+    }
     return 0;
 }
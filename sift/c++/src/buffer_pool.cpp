@@ -0,0 +1,30 @@
+#include "buffer_pool.h"
+
+wgpu::Buffer BufferPool::Acquire(size_t size, wgpu::BufferUsage usage) {
+    uint64_t bucket = 256;
+    while (bucket < size) bucket <<= 1;
+
+    for (auto& entry : entries_) {
+        if (!entry.in_use && entry.usage == (WGPUBufferUsage)usage && entry.size == bucket) {
+            entry.in_use = true;
+            return entry.buffer;
+        }
+    }
+
+    wgpu::BufferDescriptor desc = {};
+    desc.size = bucket;
+    desc.usage = usage;
+    desc.mappedAtCreation = false;
+
+    Entry entry;
+    entry.size = bucket;
+    entry.usage = (WGPUBufferUsage)usage;
+    entry.buffer = device_.createBuffer(desc);
+    entry.in_use = true;
+    entries_.push_back(entry);
+    return entries_.back().buffer;
+}
+
+void BufferPool::Reset() {
+    for (auto& entry : entries_) entry.in_use = false;
+}
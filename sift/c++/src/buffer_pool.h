@@ -0,0 +1,41 @@
+#ifndef WEBSIFTGPU_CPP_SRC_BUFFER_POOL_H_
+#define WEBSIFTGPU_CPP_SRC_BUFFER_POOL_H_
+
+#include <cstdint>
+#include <vector>
+#include <webgpu/webgpu.hpp>
+
+// Frame-scoped pool of transient GPU buffers, shared by the SIFT engines and
+// the matcher. Acquire() hands out a free pooled buffer with the requested
+// usage (sizes are bucketed, see below) or creates one; Reset() marks every
+// buffer free again at the start of the next frame or matcher call. In
+// steady state the hot path performs zero wgpu buffer allocations, removing
+// driver-side allocation jitter from the tail latency.
+//
+// Callers own the synchronization: Reset() may only run once the GPU is done
+// with the previous frame's buffers, which every current call site
+// guarantees by ending in a blocking readback.
+class BufferPool {
+ public:
+    void Init(wgpu::Device device) { device_ = device; }
+
+    // Size is rounded up to the next power of two (min 256 bytes) so buffers
+    // get reused across frames with varying keypoint counts.
+    wgpu::Buffer Acquire(size_t size, wgpu::BufferUsage usage);
+
+    // Returns every buffer to the free list; nothing is released back to the
+    // driver, the pool holds its high-water mark.
+    void Reset();
+
+ private:
+    struct Entry {
+        uint64_t size;
+        WGPUBufferUsage usage;
+        wgpu::Buffer buffer;
+        bool in_use;
+    };
+    std::vector<Entry> entries_;
+    wgpu::Device device_;
+};
+
+#endif  // WEBSIFTGPU_CPP_SRC_BUFFER_POOL_H_
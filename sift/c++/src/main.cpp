@@ -8,6 +8,7 @@
 // WebGPU API (Standard C++ Header from WebGPU-distribution)
 #include <webgpu/webgpu.hpp>
 
+#include "sift_cpu.h"
 #include "sift_default.h"
 #include "sift_packed.h"
 #include "utils.h"
@@ -72,45 +73,73 @@ wgpu::Device CreateDevice() {
 }
 
 int main(int argc, char* argv[]) {
-    if (argc < 2) {
-        std::cout << "Usage: " << argv[0] << " <image_path> [packed|unpacked] [output_json]" << std::endl;
-        return 1;
+    // Positional args plus optional --format/--gray switches anywhere.
+    std::string format = "json";
+    bool gray = false;
+    std::vector<std::string> positional;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--format" && i + 1 < argc) {
+            format = argv[++i];
+        } else if (arg.rfind("--format=", 0) == 0) {
+            format = arg.substr(9);
+        } else if (arg == "--gray") {
+            gray = true;
+        } else {
+            positional.push_back(arg);
+        }
     }
 
-    std::string image_path = argv[1];
-    std::string mode = "unpacked";
-    if (argc >= 3) {
-        mode = argv[2];
+    if (positional.empty() || (format != "json" && format != "bin")) {
+        std::cout << "Usage: " << argv[0] << " <image_path> [packed|unpacked|cpu] [output_file] [--format json|bin] [--gray]" << std::endl;
+        return 1;
     }
-    std::string output_path = "";
-    if (argc >= 4) {
-        output_path = argv[3];
+
+    std::string image_path = positional[0];
+    std::string mode = positional.size() >= 2 ? positional[1] : "unpacked";
+    std::string output_path = positional.size() >= 3 ? positional[2] : "";
+
+    // --gray uploads a single-channel buffer (r8unorm, 4x less upload);
+    // only the packed engine has the r8 input path.
+    if (gray && mode != "packed") {
+        std::cerr << "--gray requires packed mode" << std::endl;
+        return 1;
     }
 
     std::cout << "Loading image: " << image_path << std::endl;
     int width, height;
     std::vector<uint8_t> image_data;
     try {
-        image_data = utils::loadImage(image_path, &width, &height);
+        image_data = gray ? utils::loadImageGray(image_path, &width, &height)
+                          : utils::loadImage(image_path, &width, &height);
     } catch (const std::exception& e) {
         std::cerr << e.what() << std::endl;
         return 1;
     }
     std::cout << "Image size: " << width << "x" << height << std::endl;
 
-    std::cout << "Initializing WebGPU..." << std::endl;
-    wgpu::Device device = CreateDevice();
-    
     std::unique_ptr<SIFTBase> sift;
-    if (mode == "packed") {
-        std::cout << "Mode: Packed" << std::endl;
-        sift = std::make_unique<SIFTPacked>();
+    wgpu::Device device = nullptr;
+    if (mode == "cpu") {
+        // CPU engine: no adapter/device needed, usable on headless nodes
+        // where wgpu-native adapter creation fails.
+        std::cout << "Mode: CPU" << std::endl;
+        sift = std::make_unique<SIFTCpu>();
     } else {
-        std::cout << "Mode: Unpacked (Default)" << std::endl;
-        sift = std::make_unique<SIFTDefault>();
+        std::cout << "Initializing WebGPU..." << std::endl;
+        device = CreateDevice();
+        if (mode == "packed") {
+            std::cout << "Mode: Packed" << std::endl;
+            sift = std::make_unique<SIFTPacked>();
+        } else {
+            std::cout << "Mode: Unpacked (Default)" << std::endl;
+            sift = std::make_unique<SIFTDefault>();
+        }
     }
 
-    sift->Init(device);
+    SIFTOptions options;
+    options.grayscaleInput = gray;
+    sift->Init(device, options);
 
     std::cout << "Detecting keypoints..." << std::endl;
     sift->DetectKeypoints(image_data.data(), width, height);
@@ -118,22 +147,19 @@ int main(int argc, char* argv[]) {
     const auto& keypoints = sift->GetKeypoints();
     std::cout << "Found " << keypoints.size() << " keypoints." << std::endl;
 
-    // Compute Descriptors (if supported/implemented by calling ReadbackDescriptors)
-    // SIFTBase doesn't declare virtual ComputeDescriptors, but SIFTPacked has ReadbackDescriptors.
-    // We need to cast or ensure interface. SIFTBase has pure virtual? No.
-    // Let's assume SIFTPacked is used mostly.
-    
+    // Descriptor readback is part of the SIFTBase interface; all three
+    // engines fill it.
     std::vector<float> descriptors;
-    if (mode == "packed") {
-        ((SIFTPacked*)sift.get())->ReadbackDescriptors(descriptors);
-    } else {
-        // Implement for default if needed, or skip
-        // ((SIFTDefault*)sift.get())->ReadbackDescriptors(descriptors); // If Implemented
-        // For now, only Packed supports descriptors readback in this CLI example 
-        // based on previous analysis of files (SIFTDefault wasn't shown fully but likely similar)
-    }
-
-    if (!output_path.empty()) {
+    sift->ReadbackDescriptors(descriptors);
+
+    if (!output_path.empty() && format == "bin") {
+        // Binary feature file: 32-byte keypoint records + raw descriptor
+        // block, read back zero-copy via utils::FeatureFileReader.
+        std::cout << "Writing features to " << output_path << std::endl;
+        utils::writeFeatures(output_path, keypoints, descriptors.data(),
+                             descriptors.empty() ? utils::DescriptorType::None
+                                                 : utils::DescriptorType::Float32);
+    } else if (!output_path.empty()) {
         std::cout << "Writing results to " << output_path << std::endl;
         std::ofstream outfile(output_path);
         outfile << "{\n";
@@ -6,10 +6,90 @@ SIFTBase::SIFTBase()
 
 SIFTBase::~SIFTBase() {}
 
+void SIFTBase::SubmitFrame(const uint8_t* image_data, int width, int height,
+                           uint64_t frame_id, FrameCallback callback) {
+    // Synchronous fallback for engines without a native async path.
+    DetectKeypoints(image_data, width, height);
+    FrameResult result;
+    result.frame_id = frame_id;
+    result.keypoints = keypoints_;
+    if (callback) callback(std::move(result));
+}
+
+void SIFTBase::DetectKeypointsBatch(const std::vector<const uint8_t*>& images,
+                                    int width, int height) {
+    // Fallback for engines without a batched path: sequential detection.
+    batch_keypoints_.clear();
+    batch_descriptors_.clear();
+    for (const uint8_t* image : images) {
+        DetectKeypoints(image, width, height);
+        batch_keypoints_.push_back(keypoints_);
+        batch_descriptors_.emplace_back();
+    }
+}
+
 void SIFTBase::Init(wgpu::Device d, const SIFTOptions& options) {
     device_ = d;
     queue_ = d.getQueue();
     options_ = options;
+    transient_pool_.Init(d);
+}
+
+void SIFTBase::InitStageTimestamps() {
+    timestamp_period_ = wgpuQueueGetTimestampPeriod((WGPUQueue)queue_);
+    if (timestamp_period_ <= 0) timestamp_period_ = 1.0f;
+
+    wgpu::QuerySetDescriptor qDesc;
+    qDesc.type = wgpu::QueryType::Timestamp;
+    qDesc.count = kNumStageTimestamps;
+    query_set_ = device_.createQuerySet(qDesc);
+    query_resolve_buf_ = createBuffer(kNumStageTimestamps * 8, wgpu::BufferUsage::QueryResolve | wgpu::BufferUsage::CopySrc);
+    query_result_buf_ = createBuffer(kNumStageTimestamps * 8, wgpu::BufferUsage::MapRead | wgpu::BufferUsage::CopyDst);
+}
+
+void SIFTBase::WriteTimestamp(wgpu::CommandEncoder& encoder, uint32_t index) {
+    // Compute passes are the only place wgpu lets us write timestamps, so a
+    // stage boundary is an empty pass with a beginning-of-pass write.
+    wgpu::ComputePassTimestampWrites tsw;
+    tsw.querySet = query_set_;
+    tsw.beginningOfPassWriteIndex = index;
+    tsw.endOfPassWriteIndex = ~0u;
+    wgpu::ComputePassDescriptor desc;
+    desc.timestampWrites = &tsw;
+    wgpu::ComputePassEncoder pass = encoder.beginComputePass(desc);
+    pass.end();
+}
+
+void SIFTBase::EncodeStageResolve(wgpu::CommandEncoder& encoder) {
+    encoder.resolveQuerySet(query_set_, 0, kNumStageTimestamps, query_resolve_buf_, 0);
+    encoder.copyBufferToBuffer(query_resolve_buf_, 0, query_result_buf_, 0, kNumStageTimestamps * 8);
+}
+
+void SIFTBase::ReadStageTimestamps() {
+    bool done = false;
+    wgpu::BufferMapCallbackInfo callbackInfo = {};
+    callbackInfo.mode = wgpu::CallbackMode::AllowSpontaneous;
+    callbackInfo.userdata1 = &done;
+    callbackInfo.callback = [](WGPUMapAsyncStatus, WGPUStringView, void* user1, void*) {
+        *(bool*)user1 = true;
+    };
+    query_result_buf_.mapAsync(wgpu::MapMode::Read, 0, kNumStageTimestamps * 8, callbackInfo);
+    while (!done) device_.poll(true, nullptr);
+
+    const uint64_t* timestamps = (const uint64_t*)query_result_buf_.getConstMappedRange(0, kNumStageTimestamps * 8);
+    double ns_to_ms = 1e-6 * timestamp_period_;
+    profiling_.grayscale_ms = (timestamps[1] - timestamps[0]) * ns_to_ms;
+    profiling_.pyramids_ms = (timestamps[2] - timestamps[1]) * ns_to_ms;
+    profiling_.extrema_ms = (timestamps[3] - timestamps[2]) * ns_to_ms;
+    profiling_.orientation_ms = (timestamps[4] - timestamps[3]) * ns_to_ms;
+    profiling_.descriptor_ms = (timestamps[5] - timestamps[4]) * ns_to_ms;
+
+    // Total GPU time
+    uint64_t gpu_total_diff = timestamps[6] - timestamps[0];
+    if (timestamps[6] < timestamps[0]) gpu_total_diff = 0; // Handle wraps/errors
+    profiling_.total_ms = gpu_total_diff * ns_to_ms;
+
+    query_result_buf_.unmap();
 }
 
 wgpu::ShaderModule SIFTBase::CreateShaderModule(const std::string& source) {
@@ -32,7 +112,8 @@ wgpu::Buffer SIFTBase::createBuffer(size_t size, wgpu::BufferUsage usage) {
 }
 
 float SIFTBase::GetSigma(int s) {
-    return 1.6f * std::pow(2.0f, (float)s / 3.0f); // Default values
+    int scales = options_.scalesPerOctave > 0 ? options_.scalesPerOctave : 3;
+    return 1.6f * std::pow(2.0f, (float)s / (float)scales);
 }
 
 std::vector<float> SIFTBase::CreateKernel(float sigma, int radius) {
@@ -5,8 +5,11 @@
 #include <string>
 #include <memory>
 #include <map>
+#include <functional>
 #include <webgpu/webgpu.hpp>
 
+#include "buffer_pool.h"
+
 struct Keypoint {
     float x;
     float y;
@@ -22,8 +25,77 @@ struct SIFTOptions {
     bool quantizeDescriptors = false;
     float contrastThreshold = 0.03f;
     float edgeThreshold = 10.0f;
+    // When > 0, keep only the ~maxKeypoints strongest keypoints by contrast
+    // response (GPU selection stage), bounding descriptor and readback cost
+    // on keypoint-heavy frames. 0 keeps all detected keypoints.
+    int maxKeypoints = 0;
+    // Pyramid shape: fewer octaves for thumbnail-sized inputs, more for 4K
+    // archival runs. Shader-side constants are specialized at pipeline
+    // creation (WGSL overrides), so no recompile is needed. Octaves are
+    // clamped to [1, 8]; the orientation/descriptor kernels sample at most
+    // 3 scale textures, so scalesPerOctave > 3 deepens the pyramid and the
+    // extrema search but keypoints at scales > 3 sample the third texture.
+    int numOctaves = 4;
+    int scalesPerOctave = 3;
+    // Allocate the Gaussian/DoG pyramids as rgba16float instead of
+    // rgba32float, halving pyramid VRAM and blur/DoG bandwidth. DoG values
+    // are small differences of [0,1] data, well inside f16 range; run
+    // tests/test_invariance.cpp to gate whether the precision holds up for a
+    // given deployment.
+    bool halfFloatPyramids = false;
+    // Input frames are single-channel 8-bit (e.g. a planar YUV camera's Y
+    // plane) instead of RGBA8: image_data is width*height bytes, uploaded as
+    // r8unorm, cutting per-frame upload bandwidth 4x and skipping the luma
+    // conversion on the GPU. The first pass still runs as the 2x2 packing
+    // step on the packed engine.
+    bool grayscaleInput = false;
+    // Capture per-pass GPU timestamps (one span per compute pass, labeled
+    // with octave/scale) plus host-side spans around upload/encode/readback
+    // on the synchronous detection path. Export the captured window with
+    // SIFTPacked::ExportTrace() as chrome://tracing JSON. Adds two timestamp
+    // writes per pass; leave off in production.
+    bool enableTracing = false;
+};
+
+// Per-frame timing and saturation telemetry, filled by the GPU engines'
+// detection paths (see SIFTBase::GetProfiling). Stage times come from GPU
+// timestamp queries; upload/download are host-side wall clock.
+struct SIFTProfiling {
+    double total_ms = 0;
+    double upload_ms = 0;
+    double grayscale_ms = 0;
+    double pyramids_ms = 0;
+    double extrema_ms = 0;
+    double orientation_ms = 0;
+    double descriptor_ms = 0;
+    double download_ms = 0;
+
+    // Saturation telemetry. The extrema shaders append into a fixed-capacity
+    // buffer; the atomic count keeps incrementing past the capacity, so
+    // attempted > stored means keypoints were silently dropped this frame and
+    // matching quality is suspect.
+    uint32_t attempted_keypoints = 0;
+    uint32_t stored_keypoints = 0;
+    bool keypoint_overflow = false;
+    // Per-octave keypoint counts from the binning pass (index 0..7, matching
+    // SIFTPacked::kMaxOctaves), and the mean active-lane fraction of the
+    // 64-wide descriptor dispatches they produce — low occupancy means many
+    // near-empty workgroups. Engines without the binning pass leave these 0.
+    uint32_t octave_fill[8] = {};
+    double descriptor_occupancy = 0;
+};
+
+// Result of one asynchronously submitted frame (see SIFTBase::SubmitFrame).
+// Descriptors are 128 floats per keypoint; empty if the engine does not
+// support descriptor readback.
+struct FrameResult {
+    uint64_t frame_id = 0;
+    std::vector<Keypoint> keypoints;
+    std::vector<float> descriptors;
 };
 
+using FrameCallback = std::function<void(FrameResult result)>;
+
 class SIFTBase {
  public:
     SIFTBase();
@@ -32,10 +104,45 @@ class SIFTBase {
     virtual void Init(wgpu::Device device, const SIFTOptions& options = SIFTOptions());
     virtual void Resize(int width, int height) = 0;
     virtual void DetectKeypoints(const uint8_t* image_data, int width, int height) = 0;
-    
+
+    // Batched detection for a unit of work of same-sized frames (e.g. the
+    // 3-5 frames of a wigglegram): engines that support it encode all
+    // frames into one submit and read results back once, so per-frame
+    // overhead drops to the marginal GPU cost. Results land in
+    // GetBatchKeypoints()/GetBatchDescriptors(), indexed like `images`.
+    // The base implementation just loops DetectKeypoints.
+    virtual void DetectKeypointsBatch(const std::vector<const uint8_t*>& images,
+                                      int width, int height);
+
+    // Asynchronous detection: upload + encode frame_id and return without
+    // blocking on the GPU; the callback fires from WaitIdle (or a later
+    // SubmitFrame that pumps completions) once results are mapped back.
+    // The base implementation is synchronous so engines without an async
+    // path still honor the contract.
+    virtual void SubmitFrame(const uint8_t* image_data, int width, int height,
+                             uint64_t frame_id, FrameCallback callback);
+    // Blocks until all submitted frames have completed and their callbacks ran.
+    virtual void WaitIdle() {}
+
+
+    // Copies out the descriptors for the last DetectKeypoints call, 128
+    // floats per keypoint in GetKeypoints() order. Engines without
+    // descriptor support return an empty vector.
+    virtual void ReadbackDescriptors(std::vector<float>& out_descriptors) {
+        out_descriptors.clear();
+    }
+
+    const SIFTProfiling& GetProfiling() const { return profiling_; }
+
     const std::vector<Keypoint>& GetKeypoints() const { return keypoints_; }
     size_t GetKeypointsCount() const { return keypoints_.size(); }
 
+    // Per-image results of the last DetectKeypointsBatch call. Descriptors
+    // are 128 floats per keypoint; empty for engines without descriptor
+    // readback.
+    const std::vector<std::vector<Keypoint>>& GetBatchKeypoints() const { return batch_keypoints_; }
+    const std::vector<std::vector<float>>& GetBatchDescriptors() const { return batch_descriptors_; }
+
  protected:
     wgpu::Device device_;
     wgpu::Queue queue_;
@@ -45,16 +152,40 @@ class SIFTBase {
     int height_;
     
     std::vector<Keypoint> keypoints_;
-    
+    std::vector<std::vector<Keypoint>> batch_keypoints_;
+    std::vector<std::vector<float>> batch_descriptors_;
+
     // Helper methods
     wgpu::ShaderModule CreateShaderModule(const std::string& source);
     wgpu::Buffer createBuffer(size_t size, wgpu::BufferUsage usage);
 
+    // Frame-scoped transient buffers (per-pass uniforms, readback staging);
+    // engines reset it once per DetectKeypoints so steady state allocates
+    // nothing.
+    BufferPool transient_pool_;
+
     float GetSigma(int s);
     std::vector<float> CreateKernel(float sigma, int radius);
     wgpu::Buffer GetKernelBuffer(float sigma, int radius);
 
     std::map<std::string, wgpu::Buffer> kernel_cache_;
+
+    // Shared coarse stage profiling: a 7-entry timestamp query set (start,
+    // grayscale, pyramids, extrema, orientation, descriptor, end). Engines
+    // call InitStageTimestamps once from Init, WriteTimestamp at each stage
+    // boundary, EncodeStageResolve into the frame's last command buffer, and
+    // ReadStageTimestamps after that submit completes to fill profiling_.
+    static constexpr uint32_t kNumStageTimestamps = 7;
+    void InitStageTimestamps();
+    void WriteTimestamp(wgpu::CommandEncoder& encoder, uint32_t index);
+    void EncodeStageResolve(wgpu::CommandEncoder& encoder);
+    void ReadStageTimestamps();
+
+    SIFTProfiling profiling_;
+    wgpu::QuerySet query_set_;
+    wgpu::Buffer query_resolve_buf_;
+    wgpu::Buffer query_result_buf_;
+    float timestamp_period_ = 1.0f;
 };
 
 #endif  // WEBSIFTGPU_CPP_SRC_SIFT_BASE_H_
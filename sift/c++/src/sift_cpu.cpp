@@ -0,0 +1,530 @@
+#include "sift_cpu.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <condition_variable>
+#include <cstring>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#endif
+
+// Persistent worker pool: one ParallelFor at a time, chunks handed out
+// through an atomic cursor so uneven work (keypoint-heavy image regions)
+// load-balances across cores. The calling thread participates, so a
+// single-core box degrades to a plain loop.
+class SIFTCpu::ThreadPool {
+ public:
+    ThreadPool() {
+        unsigned n = std::thread::hardware_concurrency();
+        num_threads_ = n > 1 ? n : 1;
+        for (unsigned i = 0; i + 1 < num_threads_; ++i) {
+            workers_.emplace_back([this] { WorkerLoop(); });
+        }
+    }
+
+    ~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = true;
+        }
+        cv_.notify_all();
+        for (auto& t : workers_) t.join();
+    }
+
+    // Runs fn(begin, end) over [0, count) in chunks of `grain` and blocks
+    // until every chunk has finished.
+    void ParallelFor(int count, int grain, const std::function<void(int, int)>& fn) {
+        if (count <= 0) return;
+        if (grain < 1) grain = 1;
+        if (workers_.empty() || count <= grain) {
+            fn(0, count);
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            fn_ = &fn;
+            count_ = count;
+            grain_ = grain;
+            cursor_.store(0, std::memory_order_relaxed);
+            active_ = (int)workers_.size();
+            ++generation_;
+        }
+        cv_.notify_all();
+        RunChunks();
+        std::unique_lock<std::mutex> lock(mutex_);
+        done_cv_.wait(lock, [this] { return active_ == 0; });
+        fn_ = nullptr;
+    }
+
+    unsigned NumThreads() const { return num_threads_; }
+
+ private:
+    void RunChunks() {
+        for (;;) {
+            int begin = cursor_.fetch_add(grain_, std::memory_order_relaxed);
+            if (begin >= count_) return;
+            int end = begin + grain_;
+            if (end > count_) end = count_;
+            (*fn_)(begin, end);
+        }
+    }
+
+    void WorkerLoop() {
+        uint64_t seen = 0;
+        for (;;) {
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                cv_.wait(lock, [&] { return stop_ || generation_ != seen; });
+                if (stop_) return;
+                seen = generation_;
+            }
+            RunChunks();
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                if (--active_ == 0) done_cv_.notify_one();
+            }
+        }
+    }
+
+    std::vector<std::thread> workers_;
+    unsigned num_threads_ = 1;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::condition_variable done_cv_;
+    const std::function<void(int, int)>* fn_ = nullptr;
+    int count_ = 0;
+    int grain_ = 1;
+    std::atomic<int> cursor_{0};
+    int active_ = 0;
+    uint64_t generation_ = 0;
+    bool stop_ = false;
+};
+
+// TWO_PI in constants.wgsl
+static constexpr float kTwoPi = 6.283185307179586f;
+
+// Clamp-to-edge sampler, matching texture loads on the GPU side.
+static inline float at(const std::vector<float>& data, int w, int h, int x, int y) {
+    if (x < 0) x = 0;
+    if (x >= w) x = w - 1;
+    if (y < 0) y = 0;
+    if (y >= h) y = h - 1;
+    return data[(size_t)y * w + x];
+}
+
+SIFTCpu::SIFTCpu() = default;
+SIFTCpu::~SIFTCpu() = default;
+
+void SIFTCpu::Init(wgpu::Device device, const SIFTOptions& options) {
+    (void)device;  // CPU engine: no GPU resources, a null device is fine.
+    options_ = options;
+    num_octaves_ = std::max(1, std::min(options_.numOctaves, kMaxOctaves));
+    scales_per_octave_ = std::max(1, options_.scalesPerOctave);
+    pool_ = std::make_unique<ThreadPool>();
+}
+
+void SIFTCpu::Resize(int w, int h) {
+    if (gray_.w == w && gray_.h == h) return;
+
+    gray_.alloc(w, h);
+    blur_temp_.alloc(w, h);
+
+    gaussian_.assign(num_octaves_, {});
+    dog_.assign(num_octaves_, {});
+    int ow = w, oh = h;
+    for (int o = 0; o < num_octaves_; ++o) {
+        gaussian_[o].resize(scales_per_octave_ + 3);
+        dog_[o].resize(scales_per_octave_ + 2);
+        for (auto& img : gaussian_[o]) img.alloc(ow, oh);
+        for (auto& img : dog_[o]) img.alloc(ow, oh);
+        ow = std::max(1, ow / 2);
+        oh = std::max(1, oh / 2);
+    }
+}
+
+void SIFTCpu::Grayscale(const uint8_t* rgba, int width, int height, Image& out) {
+    pool_->ParallelFor(height, 16, [&](int y0, int y1) {
+        for (int y = y0; y < y1; ++y) {
+            const uint8_t* src = rgba + (size_t)y * width * 4;
+            float* dst = out.data.data() + (size_t)y * width;
+            for (int x = 0; x < width; ++x) {
+                // Same weights as grayscale.wgsl, on [0,1] data.
+                dst[x] = (0.299f * src[x * 4 + 0] + 0.587f * src[x * 4 + 1] + 0.114f * src[x * 4 + 2]) * (1.0f / 255.0f);
+            }
+        }
+    });
+}
+
+void SIFTCpu::Blur(const Image& in, Image& out, Image& temp, float sigma) {
+    int radius = (int)std::ceil(sigma * 3);
+    std::vector<float> kernel = CreateKernel(sigma, radius);
+    const float* k = kernel.data();
+    int w = in.w, h = in.h;
+
+    // Horizontal pass into temp (temp is full-resolution scratch; only the
+    // top-left w x h region is used for smaller octaves).
+    pool_->ParallelFor(h, 8, [&](int y0, int y1) {
+        for (int y = y0; y < y1; ++y) {
+            const float* src = in.data.data() + (size_t)y * w;
+            float* dst = temp.data.data() + (size_t)y * temp.w;
+            int x = 0;
+            for (; x < radius && x < w; ++x) {
+                float acc = 0;
+                for (int t = -radius; t <= radius; ++t) acc += k[t + radius] * at(in.data, w, h, x + t, y);
+                dst[x] = acc;
+            }
+            int interior_end = w - radius;
+#if defined(__AVX2__)
+            for (; x + 8 <= interior_end; x += 8) {
+                __m256 acc = _mm256_setzero_ps();
+                for (int t = 0; t < 2 * radius + 1; ++t) {
+                    acc = _mm256_add_ps(acc, _mm256_mul_ps(_mm256_set1_ps(k[t]), _mm256_loadu_ps(src + x + t - radius)));
+                }
+                _mm256_storeu_ps(dst + x, acc);
+            }
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+            for (; x + 4 <= interior_end; x += 4) {
+                float32x4_t acc = vdupq_n_f32(0.0f);
+                for (int t = 0; t < 2 * radius + 1; ++t) {
+                    acc = vmlaq_n_f32(acc, vld1q_f32(src + x + t - radius), k[t]);
+                }
+                vst1q_f32(dst + x, acc);
+            }
+#endif
+            for (; x < interior_end; ++x) {
+                float acc = 0;
+                for (int t = -radius; t <= radius; ++t) acc += k[t + radius] * src[x + t];
+                dst[x] = acc;
+            }
+            for (; x < w; ++x) {
+                float acc = 0;
+                for (int t = -radius; t <= radius; ++t) acc += k[t + radius] * at(in.data, w, h, x + t, y);
+                dst[x] = acc;
+            }
+        }
+    });
+
+    // Vertical pass: each tap reads a contiguous row, so the whole row
+    // vectorizes with unaligned loads.
+    pool_->ParallelFor(h, 8, [&](int y0, int y1) {
+        for (int y = y0; y < y1; ++y) {
+            float* dst = out.data.data() + (size_t)y * w;
+            bool interior = (y >= radius && y < h - radius);
+            if (interior) {
+                int x = 0;
+#if defined(__AVX2__)
+                for (; x + 8 <= w; x += 8) {
+                    __m256 acc = _mm256_setzero_ps();
+                    for (int t = -radius; t <= radius; ++t) {
+                        const float* src = temp.data.data() + (size_t)(y + t) * temp.w;
+                        acc = _mm256_add_ps(acc, _mm256_mul_ps(_mm256_set1_ps(k[t + radius]), _mm256_loadu_ps(src + x)));
+                    }
+                    _mm256_storeu_ps(dst + x, acc);
+                }
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+                for (; x + 4 <= w; x += 4) {
+                    float32x4_t acc = vdupq_n_f32(0.0f);
+                    for (int t = -radius; t <= radius; ++t) {
+                        const float* src = temp.data.data() + (size_t)(y + t) * temp.w;
+                        acc = vmlaq_n_f32(acc, vld1q_f32(src + x), k[t + radius]);
+                    }
+                    vst1q_f32(dst + x, acc);
+                }
+#endif
+                for (; x < w; ++x) {
+                    float acc = 0;
+                    for (int t = -radius; t <= radius; ++t) acc += k[t + radius] * temp.data[(size_t)(y + t) * temp.w + x];
+                    dst[x] = acc;
+                }
+            } else {
+                for (int x = 0; x < w; ++x) {
+                    float acc = 0;
+                    for (int t = -radius; t <= radius; ++t) {
+                        int yy = y + t;
+                        if (yy < 0) yy = 0;
+                        if (yy >= h) yy = h - 1;
+                        acc += k[t + radius] * temp.data[(size_t)yy * temp.w + x];
+                    }
+                    dst[x] = acc;
+                }
+            }
+        }
+    });
+}
+
+void SIFTCpu::Downsample(const Image& in, Image& out) {
+    // Nearest-neighbor decimation, matching downsample.wgsl.
+    pool_->ParallelFor(out.h, 32, [&](int y0, int y1) {
+        for (int y = y0; y < y1; ++y) {
+            float* dst = out.data.data() + (size_t)y * out.w;
+            const float* src = in.data.data() + (size_t)(y * 2) * in.w;
+            for (int x = 0; x < out.w; ++x) dst[x] = src[x * 2];
+        }
+    });
+}
+
+void SIFTCpu::Subtract(const Image& a, const Image& b, Image& out) {
+    size_t n = (size_t)out.w * out.h;
+    const float* pa = a.data.data();
+    const float* pb = b.data.data();
+    float* po = out.data.data();
+    pool_->ParallelFor((int)n, 1 << 16, [&](int i0, int i1) {
+        int i = i0;
+#if defined(__AVX2__)
+        for (; i + 8 <= i1; i += 8) {
+            _mm256_storeu_ps(po + i, _mm256_sub_ps(_mm256_loadu_ps(pb + i), _mm256_loadu_ps(pa + i)));
+        }
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+        for (; i + 4 <= i1; i += 4) {
+            vst1q_f32(po + i, vsubq_f32(vld1q_f32(pb + i), vld1q_f32(pa + i)));
+        }
+#endif
+        for (; i < i1; ++i) po[i] = pb[i] - pa[i];
+    });
+}
+
+void SIFTCpu::DetectExtrema(int octave, int scale, const Image& prev, const Image& curr, const Image& next,
+                            std::vector<CpuKeypoint>& out) {
+    int w = curr.w, h = curr.h;
+    float threshold = options_.contrastThreshold / scales_per_octave_;
+    float r = options_.edgeThreshold;
+    float scale_mult = std::pow(2.0f, (float)octave);
+    float sigma = kSigmaBase * std::pow(2.0f, (float)scale / scales_per_octave_) * scale_mult;
+
+    std::mutex merge_mutex;
+    pool_->ParallelFor(h - 2, 8, [&](int y0, int y1) {
+        std::vector<CpuKeypoint> local;
+        for (int yi = y0; yi < y1; ++yi) {
+            int y = yi + 1;
+            for (int x = 1; x < w - 1; ++x) {
+                float val = curr.data[(size_t)y * w + x];
+                if (std::fabs(val) < threshold) continue;
+
+                bool is_max = true, is_min = true;
+                for (int vz = -1; vz <= 1 && (is_max || is_min); ++vz) {
+                    const Image& img = vz < 0 ? prev : (vz > 0 ? next : curr);
+                    for (int vy = -1; vy <= 1; ++vy) {
+                        for (int vx = -1; vx <= 1; ++vx) {
+                            if (vz == 0 && vy == 0 && vx == 0) continue;
+                            float n = img.data[(size_t)(y + vy) * w + (x + vx)];
+                            if (n >= val) is_max = false;
+                            if (n <= val) is_min = false;
+                        }
+                    }
+                }
+                if (!is_max && !is_min) continue;
+
+                // Edge rejection via the Hessian eigenvalue ratio (extrema.wgsl)
+                const float* row = curr.data.data() + (size_t)y * w;
+                float dxx = row[x + 1] + row[x - 1] - 2.0f * val;
+                float dyy = curr.data[(size_t)(y + 1) * w + x] + curr.data[(size_t)(y - 1) * w + x] - 2.0f * val;
+                float dxy = (curr.data[(size_t)(y + 1) * w + (x + 1)] - curr.data[(size_t)(y - 1) * w + (x + 1)] -
+                             curr.data[(size_t)(y + 1) * w + (x - 1)] + curr.data[(size_t)(y - 1) * w + (x - 1)]) * 0.25f;
+                float tr = dxx + dyy;
+                float det = dxx * dyy - dxy * dxy;
+                if (!(det > 0.0f && (tr * tr * r) < ((r + 1.0f) * (r + 1.0f) * det))) continue;
+
+                CpuKeypoint ckp;
+                ckp.kp.x = (float)x * scale_mult;
+                ckp.kp.y = (float)y * scale_mult;
+                ckp.kp.octave = (float)octave;
+                ckp.kp.scale = (float)scale;
+                ckp.kp.sigma = sigma;
+                ckp.kp.orientation = 0.0f;
+                ckp.response = std::fabs(val);
+                local.push_back(ckp);
+            }
+        }
+        if (!local.empty()) {
+            std::lock_guard<std::mutex> lock(merge_mutex);
+            out.insert(out.end(), local.begin(), local.end());
+        }
+    });
+}
+
+void SIFTCpu::ComputeOrientation(const Image& img, Keypoint& kp) {
+    int octave = (int)kp.octave;
+    float inv_scale = 1.0f / std::pow(2.0f, (float)octave);
+    int x = (int)std::lround(kp.x * inv_scale);
+    int y = (int)std::lround(kp.y * inv_scale);
+    int scale = (int)kp.scale;
+
+    float sigma = kSigmaBase * std::pow(2.0f, (float)scale / scales_per_octave_);
+    int radius = (int)std::lround(sigma * 1.5f * 3.0f);
+    float radius_sq = (float)(radius * radius);
+
+    float hist[kOriBins] = {};
+    for (int dy = -radius; dy <= radius; ++dy) {
+        for (int dx = -radius; dx <= radius; ++dx) {
+            float r2 = (float)(dx * dx + dy * dy);
+            if (r2 > radius_sq) continue;
+            int px = x + dx, py = y + dy;
+            if (px < 1 || px >= img.w - 1 || py < 1 || py >= img.h - 1) continue;
+            float rx = img.data[(size_t)py * img.w + (px + 1)] - img.data[(size_t)py * img.w + (px - 1)];
+            float ry = img.data[(size_t)(py + 1) * img.w + px] - img.data[(size_t)(py - 1) * img.w + px];
+            float mag = std::sqrt(rx * rx + ry * ry);
+            float sigma_w = 1.5f * sigma;
+            float weight = std::exp(-r2 / (2.0f * sigma_w * sigma_w));
+            float ang = std::atan2(ry, rx);
+            if (ang < 0.0f) ang += kTwoPi;
+            int bin = (int)std::floor(ang * kOriBins / (kTwoPi)) % kOriBins;
+            hist[bin] += mag * weight;
+        }
+    }
+
+    // Smooth [0.25, 0.5, 0.25] and take the interpolated peak (orientation.wgsl)
+    float smoothed[kOriBins];
+    for (int i = 0; i < kOriBins; ++i) {
+        smoothed[i] = 0.25f * hist[(i + kOriBins - 1) % kOriBins] + 0.5f * hist[i] + 0.25f * hist[(i + 1) % kOriBins];
+    }
+    int max_bin = 0;
+    float max_val = -1.0f;
+    for (int i = 0; i < kOriBins; ++i) {
+        if (smoothed[i] > max_val) { max_val = smoothed[i]; max_bin = i; }
+    }
+    float left = smoothed[(max_bin + kOriBins - 1) % kOriBins];
+    float right = smoothed[(max_bin + 1) % kOriBins];
+    float denom = left - 2.0f * max_val + right;
+    float peak = (float)max_bin + (denom != 0.0f ? 0.5f * (left - right) / denom : 0.0f);
+    kp.orientation = peak * kTwoPi / kOriBins;
+}
+
+void SIFTCpu::ComputeDescriptor(const Image& img, const Keypoint& kp, float* out) {
+    float inv_scale = 1.0f / std::pow(2.0f, kp.octave);
+    float x = kp.x * inv_scale;
+    float y = kp.y * inv_scale;
+    int scale = (int)kp.scale;
+    float angle = kp.orientation;
+    float cos_t = std::cos(angle);
+    float sin_t = std::sin(angle);
+
+    float sigma = kSigmaBase * std::pow(2.0f, (float)scale / scales_per_octave_);
+    float step = 0.75f * sigma;  // DESC_STEP_FACTOR
+
+    float desc[128] = {};
+    auto bilinear = [&](float sx, float sy) {
+        int x0 = (int)std::floor(sx);
+        int y0 = (int)std::floor(sy);
+        float wx = sx - x0, wy = sy - y0;
+        float v00 = at(img.data, img.w, img.h, x0, y0);
+        float v10 = at(img.data, img.w, img.h, x0 + 1, y0);
+        float v01 = at(img.data, img.w, img.h, x0, y0 + 1);
+        float v11 = at(img.data, img.w, img.h, x0 + 1, y0 + 1);
+        return (v00 * (1 - wx) + v10 * wx) * (1 - wy) + (v01 * (1 - wx) + v11 * wx) * wy;
+    };
+
+    for (int r = -8; r < 8; ++r) {
+        for (int c = -8; c < 8; ++c) {
+            float rot_x = step * (c * cos_t - r * sin_t);
+            float rot_y = step * (c * sin_t + r * cos_t);
+            float sx = x + rot_x;
+            float sy = y + rot_y;
+            if (sx < 2.0f || sx >= img.w - 2.0f || sy < 2.0f || sy >= img.h - 2.0f) continue;
+
+            float dx = bilinear(sx + 1.0f, sy) - bilinear(sx - 1.0f, sy);
+            float dy = bilinear(sx, sy + 1.0f) - bilinear(sx, sy - 1.0f);
+            float mag = std::sqrt(dx * dx + dy * dy);
+            float ori = std::atan2(dy, dx) - angle;
+            while (ori < 0.0f) ori += kTwoPi;
+            while (ori >= kTwoPi) ori -= kTwoPi;
+
+            float rbin = (r + 8.0f) / 4.0f - 0.5f;
+            float cbin = (c + 8.0f) / 4.0f - 0.5f;
+            float obin = ori * 8.0f / (kTwoPi);
+            float mag_w = mag * std::exp(-(float)(r * r + c * c) / 32.0f);
+
+            for (int dr = 0; dr < 2; ++dr) {
+                int ri = (int)std::floor(rbin) + dr;
+                if (ri < 0 || ri >= 4) continue;
+                float r_w = dr == 1 ? rbin - std::floor(rbin) : 1.0f - (rbin - std::floor(rbin));
+                for (int dc = 0; dc < 2; ++dc) {
+                    int ci = (int)std::floor(cbin) + dc;
+                    if (ci < 0 || ci >= 4) continue;
+                    float c_w = dc == 1 ? cbin - std::floor(cbin) : 1.0f - (cbin - std::floor(cbin));
+                    for (int do_idx = 0; do_idx < 2; ++do_idx) {
+                        int oi = ((int)std::floor(obin) + do_idx + 8) % 8;
+                        float o_w = do_idx == 1 ? obin - std::floor(obin) : 1.0f - (obin - std::floor(obin));
+                        desc[(ri * 4 + ci) * 8 + oi] += mag_w * r_w * c_w * o_w;
+                    }
+                }
+            }
+        }
+    }
+
+    float norm = 0;
+    for (int k = 0; k < 128; ++k) norm += desc[k] * desc[k];
+    norm = std::sqrt(norm) + 0.00001f;
+    for (int k = 0; k < 128; ++k) desc[k] = std::min(0.2f, desc[k] / norm);
+    norm = 0;
+    for (int k = 0; k < 128; ++k) norm += desc[k] * desc[k];
+    norm = std::sqrt(norm) + 0.00001f;
+    for (int k = 0; k < 128; ++k) out[k] = desc[k] / norm;
+}
+
+void SIFTCpu::DetectKeypoints(const uint8_t* image_data, int width, int height) {
+    keypoints_.clear();
+    descriptors_.clear();
+
+    width_ = width;
+    height_ = height;
+    Resize(width, height);
+
+    Grayscale(image_data, width, height, gray_);
+
+    // Gaussian/DoG pyramid, same sigma schedule as SIFTPacked::BuildPyramids.
+    for (int o = 0; o < num_octaves_; ++o) {
+        if (o == 0) {
+            Blur(gray_, gaussian_[0][0], blur_temp_, kSigmaBase);
+        } else {
+            Downsample(gaussian_[o - 1][scales_per_octave_], gaussian_[o][0]);
+        }
+        for (int s = 1; s < (int)gaussian_[o].size(); ++s) {
+            float sigma = GetSigma(s);
+            float prev_sigma = GetSigma(s - 1);
+            float diff = std::sqrt(sigma * sigma - prev_sigma * prev_sigma);
+            Blur(gaussian_[o][s - 1], gaussian_[o][s], blur_temp_, diff);
+        }
+        for (int s = 0; s < (int)dog_[o].size(); ++s) {
+            Subtract(gaussian_[o][s], gaussian_[o][s + 1], dog_[o][s]);
+        }
+    }
+
+    std::vector<CpuKeypoint> detected;
+    for (int o = 0; o < num_octaves_; ++o) {
+        for (int s = 1; s <= scales_per_octave_; ++s) {
+            DetectExtrema(o, s, dog_[o][s - 1], dog_[o][s], dog_[o][s + 1], detected);
+        }
+    }
+
+    // Top-K by contrast response, mirroring select_keypoints.wgsl.
+    if (options_.maxKeypoints > 0 && (int)detected.size() > options_.maxKeypoints) {
+        std::nth_element(detected.begin(), detected.begin() + options_.maxKeypoints, detected.end(),
+                         [](const CpuKeypoint& a, const CpuKeypoint& b) { return a.response > b.response; });
+        detected.resize(options_.maxKeypoints);
+    }
+
+    keypoints_.resize(detected.size());
+    descriptors_.resize(detected.size() * 128);
+    pool_->ParallelFor((int)detected.size(), 16, [&](int i0, int i1) {
+        for (int i = i0; i < i1; ++i) {
+            Keypoint kp = detected[i].kp;
+            // The GPU binds at most 3 scale textures; clamp identically.
+            int scale_idx = std::min((int)kp.scale, 3);
+            const Image& img = gaussian_[(int)kp.octave][scale_idx];
+            ComputeOrientation(img, kp);
+            ComputeDescriptor(img, kp, descriptors_.data() + (size_t)i * 128);
+            keypoints_[i] = kp;
+        }
+    });
+}
+
+void SIFTCpu::ReadbackDescriptors(std::vector<float>& out_descriptors) {
+    out_descriptors = descriptors_;
+}
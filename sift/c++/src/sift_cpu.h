@@ -0,0 +1,74 @@
+#ifndef WEBSIFTGPU_CPP_SRC_SIFT_CPU_H_
+#define WEBSIFTGPU_CPP_SRC_SIFT_CPU_H_
+
+#include "sift_base.h"
+
+#include <memory>
+
+// CPU fallback engine: the same pipeline as the GPU engines (grayscale ->
+// Gaussian/DoG pyramid -> extrema -> orientation -> descriptors) run on the
+// host, mirroring the packed shaders' math so results line up with
+// SIFTPacked. Blur/DoG kernels are AVX2/NEON-vectorized where the toolchain
+// enables those instruction sets, and every stage is parallelized across a
+// thread pool. Several times slower than the GPU path, but it runs on nodes
+// where adapter creation fails and doubles as a correctness reference.
+class SIFTCpu : public SIFTBase {
+ public:
+    SIFTCpu();
+    ~SIFTCpu();
+
+    // device may be null: the CPU engine never touches WebGPU.
+    void Init(wgpu::Device device, const SIFTOptions& options = SIFTOptions()) override;
+    void Resize(int width, int height) override;
+    void DetectKeypoints(const uint8_t* image_data, int width, int height) override;
+
+    // Descriptors are computed during DetectKeypoints; this just copies them
+    // out.
+    void ReadbackDescriptors(std::vector<float>& out_descriptors) override;
+
+ private:
+    // Single-channel float image, logical (unpacked) resolution.
+    struct Image {
+        int w = 0;
+        int h = 0;
+        std::vector<float> data;
+        void alloc(int width, int height) { w = width; h = height; data.assign((size_t)w * h, 0.0f); }
+    };
+
+    // Detected keypoint plus its contrast response, kept for top-K selection
+    // (the GPU stores the response in the spare p1 field).
+    struct CpuKeypoint {
+        Keypoint kp;
+        float response;
+    };
+
+    class ThreadPool;
+
+    void Grayscale(const uint8_t* rgba, int width, int height, Image& out);
+    void Blur(const Image& in, Image& out, Image& temp, float sigma);
+    void Downsample(const Image& in, Image& out);
+    void Subtract(const Image& a, const Image& b, Image& out);
+    void DetectExtrema(int octave, int scale, const Image& prev, const Image& curr, const Image& next,
+                       std::vector<CpuKeypoint>& out);
+    void ComputeOrientation(const Image& img, Keypoint& kp);
+    void ComputeDescriptor(const Image& img, const Keypoint& kp, float* desc);
+
+    std::unique_ptr<ThreadPool> pool_;
+
+    // Pyramid storage, reallocated only on resolution change (see Resize).
+    std::vector<std::vector<Image>> gaussian_;
+    std::vector<std::vector<Image>> dog_;
+    Image gray_;
+    Image blur_temp_;
+
+    std::vector<float> descriptors_;
+
+    int num_octaves_ = 4;
+    int scales_per_octave_ = 3;
+
+    static constexpr int kMaxOctaves = 8;
+    static constexpr float kSigmaBase = 1.6f;
+    static constexpr int kOriBins = 36;
+};
+
+#endif  // WEBSIFTGPU_CPP_SRC_SIFT_CPU_H_
@@ -4,7 +4,9 @@
 // Check content.
 
 #include <iostream>
+#include <chrono>
 #include <cmath>
+#include <cstring>
 #include <algorithm>
 #include <webgpu/webgpu.hpp> // Ensure using the same wrapper
 #include "utils.h"
@@ -22,6 +24,7 @@ void SIFTDefault::Init(wgpu::Device device, const SIFTOptions& options) {
     SIFTBase::Init(device, options);
     InitPipelines();
     InitBuffers();
+    InitStageTimestamps();
 }
 
 std::string SIFTDefault::loadShader(const std::string& filename) {
@@ -135,6 +138,20 @@ void SIFTDefault::DetectKeypoints(const uint8_t* image_data, int width, int heig
     width_ = width;
     height_ = height;
     keypoints_.clear();
+    // The previous frame ended in a blocking readback, so its transient
+    // buffers (per-octave uniforms, readback staging) are free to reuse.
+    transient_pool_.Reset();
+
+    // Stage boundary timestamp: this engine submits one command buffer per
+    // pass, so each boundary is its own tiny submit (see SIFTBase helpers).
+    auto stamp = [&](uint32_t index) {
+        wgpu::CommandEncoder enc = device_.createCommandEncoder();
+        WriteTimestamp(enc, index);
+        wgpu::CommandBuffer cmd = enc.finish();
+        queue_.submit(1, &cmd);
+    };
+
+    auto t0 = std::chrono::steady_clock::now();
 
     // Create Input Texture
     wgpu::TextureDescriptor desc;
@@ -161,12 +178,27 @@ void SIFTDefault::DetectKeypoints(const uint8_t* image_data, int width, int heig
     uint32_t zero = 0;
     queue_.writeBuffer(buffers_.keypoints, 0, &zero, 4);
 
+    auto t1 = std::chrono::steady_clock::now();
+    profiling_.upload_ms = std::chrono::duration<double, std::milli>(t1 - t0).count();
+
+    stamp(0);
     RunGrayscale(pyramid_cache_->base_texture);
+    stamp(1);
     BuildPyramids();
+    stamp(2);
     DetectExtrema();
+    stamp(3);
     RunPrepareDispatch();
     ComputeOrientations();
+    stamp(4);
+    RunComputeDescriptors();
+    stamp(5);
+    stamp(6);
+
+    auto t2 = std::chrono::steady_clock::now();
     ReadbackKeypoints();
+    auto t3 = std::chrono::steady_clock::now();
+    profiling_.download_ms = std::chrono::duration<double, std::milli>(t3 - t2).count();
 }
 
 void SIFTDefault::RunGrayscale(wgpu::Texture output_tex) {
@@ -408,7 +440,7 @@ void SIFTDefault::ComputeOrientations() {
     for (int o = 0; o < kNumOctaves; ++o) {
         struct { int w, h, o; } params = { w, h, o };
         
-        wgpu::Buffer params_buf = createBuffer(12, wgpu::BufferUsage::Uniform | wgpu::BufferUsage::CopyDst);
+        wgpu::Buffer params_buf = transient_pool_.Acquire(12, wgpu::BufferUsage::Uniform | wgpu::BufferUsage::CopyDst);
         queue_.writeBuffer(params_buf, 0, &params, sizeof(params));
 
         wgpu::BindGroupEntry entries[5];
@@ -437,6 +469,43 @@ void SIFTDefault::ComputeOrientations() {
     }
 }
 
+void SIFTDefault::RunComputeDescriptors() {
+    int w = width_;
+    int h = height_;
+
+    for (int o = 0; o < kNumOctaves; ++o) {
+        struct { int w, h, o, pad; } params = { w, h, o, 0 };
+
+        wgpu::Buffer params_buf = transient_pool_.Acquire(16, wgpu::BufferUsage::Uniform | wgpu::BufferUsage::CopyDst);
+        queue_.writeBuffer(params_buf, 0, &params, sizeof(params));
+
+        wgpu::BindGroupEntry entries[6];
+        entries[0].binding = 0; entries[0].buffer = params_buf; entries[0].size = 16;
+        entries[1].binding = 1; entries[1].buffer = buffers_.keypoints; entries[1].size = buffers_.keypoints.getSize();
+        entries[2].binding = 2; entries[2].buffer = buffers_.descriptors; entries[2].size = buffers_.descriptors.getSize();
+        entries[3].binding = 3; entries[3].textureView = pyramid_cache_->gaussian_pyramid[o][1].createView();
+        entries[4].binding = 4; entries[4].textureView = pyramid_cache_->gaussian_pyramid[o][2].createView();
+        entries[5].binding = 5; entries[5].textureView = pyramid_cache_->gaussian_pyramid[o][3].createView();
+
+        wgpu::BindGroupDescriptor desc;
+        desc.layout = pipeline_descriptor_.getBindGroupLayout(0);
+        desc.entryCount = 6;
+        desc.entries = entries;
+        wgpu::BindGroup bind = device_.createBindGroup(desc);
+
+        wgpu::CommandEncoder enc = device_.createCommandEncoder();
+        wgpu::ComputePassEncoder pass = enc.beginComputePass();
+        pass.setPipeline(pipeline_descriptor_);
+        pass.setBindGroup(0,  bind, 0, nullptr);
+        pass.dispatchWorkgroupsIndirect(buffers_.indirect_dispatch, 12); // Offset 12: descriptor dispatch params
+        pass.end();
+        wgpu::CommandBuffer cmd = enc.finish();
+        queue_.submit(1, &cmd);
+
+        w /= 2; h /= 2;
+    }
+}
+
 // Helper for static callback
 static volatile bool g_map_done = false;
 static void MapCallback(WGPUMapAsyncStatus, WGPUStringView, void*, void*) {
@@ -444,9 +513,10 @@ static void MapCallback(WGPUMapAsyncStatus, WGPUStringView, void*, void*) {
 }
 
 void SIFTDefault::ReadbackKeypoints() {
-    wgpu::Buffer count_buf = createBuffer(4, wgpu::BufferUsage::MapRead | wgpu::BufferUsage::CopyDst);
+    wgpu::Buffer count_buf = transient_pool_.Acquire(4, wgpu::BufferUsage::MapRead | wgpu::BufferUsage::CopyDst);
     wgpu::CommandEncoder enc = device_.createCommandEncoder();
     enc.copyBufferToBuffer(buffers_.keypoints, 0, count_buf, 0, 4);
+    EncodeStageResolve(enc);
     wgpu::CommandBuffer cmd = enc.finish();
     queue_.submit(1, &cmd);
 
@@ -460,17 +530,30 @@ void SIFTDefault::ReadbackKeypoints() {
     count_buf.mapAsync(wgpu::MapMode::Read, 0, 4, callbackInfo);
 
     while (!g_map_done) {
-        device_.poll(false, nullptr);
+        device_.poll(true, nullptr);
     }
 
     const uint32_t* mapped_count = (const uint32_t*)count_buf.getConstMappedRange(0, 4);
     uint32_t count = *mapped_count;
     count_buf.unmap();
 
+    // The extrema count runs past the buffer capacity on saturated frames
+    // (appends beyond it are discarded); clamp before sizing the readback.
+    profiling_.attempted_keypoints = count;
+    profiling_.keypoint_overflow = count > (uint32_t)kMaxKeypoints;
+    if (profiling_.keypoint_overflow) {
+        std::cerr << "[SIFTDefault] Keypoint buffer saturated: " << count
+                  << " extrema for " << kMaxKeypoints << " slots" << std::endl;
+        count = kMaxKeypoints;
+    }
+    profiling_.stored_keypoints = count;
+
+    ReadStageTimestamps();
+
     if (count == 0) return;
 
     size_t kp_byte_size = count * 32;
-    wgpu::Buffer read_buf = createBuffer(kp_byte_size, wgpu::BufferUsage::MapRead | wgpu::BufferUsage::CopyDst);
+    wgpu::Buffer read_buf = transient_pool_.Acquire(kp_byte_size, wgpu::BufferUsage::MapRead | wgpu::BufferUsage::CopyDst);
     enc = device_.createCommandEncoder();
     enc.copyBufferToBuffer(buffers_.keypoints, 16, read_buf, 0, kp_byte_size);
     cmd = enc.finish();
@@ -480,7 +563,7 @@ void SIFTDefault::ReadbackKeypoints() {
     read_buf.mapAsync(wgpu::MapMode::Read, 0, kp_byte_size, callbackInfo);
 
     while (!g_map_done) {
-        device_.poll(false, nullptr);
+        device_.poll(true, nullptr);
     }
 
     const float* mapped_data = (const float*)read_buf.getConstMappedRange(0, kp_byte_size);
@@ -496,3 +579,28 @@ void SIFTDefault::ReadbackKeypoints() {
     }
     read_buf.unmap();
 }
+
+void SIFTDefault::ReadbackDescriptors(std::vector<float>& out_descriptors) {
+    size_t count = keypoints_.size();
+    if (count == 0) {
+        out_descriptors.clear();
+        return;
+    }
+    size_t size = count * 128 * 4;
+    wgpu::Buffer read_buf = transient_pool_.Acquire(size, wgpu::BufferUsage::MapRead | wgpu::BufferUsage::CopyDst);
+    wgpu::CommandEncoder enc = device_.createCommandEncoder();
+    enc.copyBufferToBuffer(buffers_.descriptors, 0, read_buf, 0, size);
+    wgpu::CommandBuffer cmd = enc.finish();
+    queue_.submit(1, &cmd);
+
+    g_map_done = false;
+    wgpu::BufferMapCallbackInfo callbackInfo = {};
+    callbackInfo.mode = wgpu::CallbackMode::AllowSpontaneous;
+    callbackInfo.callback = MapCallback;
+    read_buf.mapAsync(wgpu::MapMode::Read, 0, size, callbackInfo);
+    while (!g_map_done) device_.poll(true, nullptr);
+
+    out_descriptors.resize(count * 128);
+    std::memcpy(out_descriptors.data(), read_buf.getConstMappedRange(0, size), size);
+    read_buf.unmap();
+}
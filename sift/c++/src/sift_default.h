@@ -11,6 +11,7 @@ class SIFTDefault : public SIFTBase {
     void Init(wgpu::Device device, const SIFTOptions& options = SIFTOptions()) override;
     void Resize(int width, int height) override;
     void DetectKeypoints(const uint8_t* image_data, int width, int height) override;
+    void ReadbackDescriptors(std::vector<float>& out_descriptors) override;
 
  private:
     void InitPipelines();
@@ -29,6 +30,7 @@ class SIFTDefault : public SIFTBase {
     void DetectExtrema();
     void RunPrepareDispatch();
     void ComputeOrientations();
+    void RunComputeDescriptors();
     void ReadbackKeypoints();
 
     // Data
@@ -3,8 +3,10 @@
 #include "embedded_shaders.h"
 #include "utils.h"
 #include <iostream>
+#include <algorithm>
 #include <cstring>
 #include <cmath>
+#include <memory>
 
 struct GPUMatchResult {
     int32_t bestIdx;
@@ -13,16 +15,34 @@ struct GPUMatchResult {
     float pad;
 };
 
+// Matches CompactMatch in matcher_compact.wgsl
+struct GPUCompactMatch {
+    int32_t queryIdx;
+    int32_t trainIdx;
+    float distSq;
+    float pad;
+};
+
 SIFTMatcher::SIFTMatcher() = default;
 SIFTMatcher::~SIFTMatcher() = default;
 
 void SIFTMatcher::Init(wgpu::Device device) {
     device_ = device;
     queue_ = device.getQueue();
+    transient_pool_.Init(device);
+
+    // Same overlapped compilation as SIFTPacked::InitPipelines: the backend
+    // compiles all kernels concurrently and we block once at the end.
+    struct PendingPipeline {
+        wgpu::ComputePipeline* target;
+        std::string name;
+        bool done = false;
+    };
+    std::vector<std::unique_ptr<PendingPipeline>> pending;
 
-    auto create_pipeline = [&](const std::string& name) {
+    auto create_pipeline = [&](wgpu::ComputePipeline* target, const std::string& name) {
         std::string code = loadShader(name);
-        if (code.empty()) return wgpu::ComputePipeline();
+        if (code.empty()) return;
         wgpu::ShaderModuleDescriptor sd = {};
         wgpu::ShaderSourceWGSL wd = {};
         wd.chain.sType = wgpu::SType::ShaderSourceWGSL;
@@ -32,12 +52,43 @@ void SIFTMatcher::Init(wgpu::Device device) {
         wgpu::ComputePipelineDescriptor pd = {};
         pd.compute.module = mod;
         pd.compute.entryPoint = wgpu::StringView("main");
-        return device_.createComputePipeline(pd);
+
+        pending.push_back(std::unique_ptr<PendingPipeline>(new PendingPipeline{target, name}));
+        PendingPipeline* p = pending.back().get();
+
+        wgpu::CreateComputePipelineAsyncCallbackInfo callbackInfo = {};
+        callbackInfo.mode = wgpu::CallbackMode::AllowSpontaneous;
+        callbackInfo.userdata1 = p;
+        callbackInfo.callback = [](WGPUCreatePipelineAsyncStatus status, WGPUComputePipeline pipeline,
+                                   WGPUStringView message, void* user1, void*) {
+            PendingPipeline* pp = (PendingPipeline*)user1;
+            if (status == WGPUCreatePipelineAsyncStatus_Success) {
+                *pp->target = pipeline;
+            } else {
+                std::cerr << "[SIFTMatcher] Pipeline creation failed for " << pp->name;
+                if (message.data) std::cerr << ": " << std::string(message.data, message.length);
+                std::cerr << std::endl;
+            }
+            pp->done = true;
+        };
+        device_.createComputePipelineAsync(pd, callbackInfo);
     };
 
-    pipeline_ = create_pipeline("matcher.wgsl");
-    pipeline_quant_ = create_pipeline("matcher_quantized.wgsl");
-    pipeline_guided_ = create_pipeline("matcher_guided.wgsl");
+    create_pipeline(&pipeline_, "matcher.wgsl");
+    create_pipeline(&pipeline_quant_, "matcher_quantized.wgsl");
+    create_pipeline(&pipeline_guided_, "matcher_guided.wgsl");
+    create_pipeline(&pipeline_tiled_, "matcher_tiled.wgsl");
+    create_pipeline(&pipeline_compact_, "matcher_compact.wgsl");
+    create_pipeline(&pipeline_cross_check_, "matcher_cross_check.wgsl");
+    create_pipeline(&pipeline_ivf_assign_, "matcher_ivf_assign.wgsl");
+    create_pipeline(&pipeline_ivf_, "matcher_ivf.wgsl");
+
+    for (;;) {
+        bool all_done = true;
+        for (auto& p : pending) all_done = all_done && p->done;
+        if (all_done) break;
+        device_.poll(true, nullptr);
+    }
 }
 
 std::string SIFTMatcher::loadShader(const std::string& name) {
@@ -58,6 +109,14 @@ std::string SIFTMatcher::loadShader(const std::string& name) {
     return "";
 }
 
+wgpu::Buffer SIFTMatcher::AcquireReadbackStaging(size_t size) {
+    if (size > readback_staging_size_) {
+        readback_staging_ = createBuffer(size, wgpu::BufferUsage::MapRead | wgpu::BufferUsage::CopyDst);
+        readback_staging_size_ = size;
+    }
+    return readback_staging_;
+}
+
 wgpu::Buffer SIFTMatcher::createBuffer(size_t size, wgpu::BufferUsage usage) {
     wgpu::BufferDescriptor desc = {};
     desc.size = (size + 3) & ~3u;
@@ -65,12 +124,14 @@ wgpu::Buffer SIFTMatcher::createBuffer(size_t size, wgpu::BufferUsage usage) {
     return device_.createBuffer(desc);
 }
 
-std::vector<Match> SIFTMatcher::MatchDescriptors(const std::vector<float>& descA, 
-                                            const std::vector<float>& descB, 
+std::vector<Match> SIFTMatcher::MatchDescriptors(const std::vector<float>& descA,
+                                            const std::vector<float>& descB,
                                             float ratio_threshold,
-                                            bool quantize) {
+                                            bool quantize,
+                                            bool tiled) {
     std::vector<Match> matches;
     if (descA.empty() || descB.empty()) return matches;
+    TransientScope transients(this);
 
     uint32_t countA = descA.size() / 128;
     uint32_t countB = descB.size() / 128;
@@ -101,87 +162,471 @@ std::vector<Match> SIFTMatcher::MatchDescriptors(const std::vector<float>& descA
                 qB[i*32 + k] = v;
             }
         }
-        bufA = createBuffer(sizeA, wgpu::BufferUsage::Storage | wgpu::BufferUsage::CopyDst);
-        bufB = createBuffer(sizeB, wgpu::BufferUsage::Storage | wgpu::BufferUsage::CopyDst);
+        bufA = transient_pool_.Acquire(sizeA, wgpu::BufferUsage::Storage | wgpu::BufferUsage::CopyDst);
+        bufB = transient_pool_.Acquire(sizeB, wgpu::BufferUsage::Storage | wgpu::BufferUsage::CopyDst);
         queue_.writeBuffer(bufA, 0, qA.data(), sizeA);
         queue_.writeBuffer(bufB, 0, qB.data(), sizeB);
     } else {
         sizeA = descA.size() * 4;
         sizeB = descB.size() * 4;
-        bufA = createBuffer(sizeA, wgpu::BufferUsage::Storage | wgpu::BufferUsage::CopyDst);
-        bufB = createBuffer(sizeB, wgpu::BufferUsage::Storage | wgpu::BufferUsage::CopyDst);
+        bufA = transient_pool_.Acquire(sizeA, wgpu::BufferUsage::Storage | wgpu::BufferUsage::CopyDst);
+        bufB = transient_pool_.Acquire(sizeB, wgpu::BufferUsage::Storage | wgpu::BufferUsage::CopyDst);
         queue_.writeBuffer(bufA, 0, descA.data(), sizeA);
         queue_.writeBuffer(bufB, 0, descB.data(), sizeB);
     }
 
+    return MatchDescriptors(bufA, countA, bufB, countB, ratio_threshold, quantize, tiled);
+}
+
+std::vector<Match> SIFTMatcher::MatchDescriptors(const std::vector<uint8_t>& descA,
+                                                 const std::vector<uint8_t>& descB,
+                                                 float ratio_threshold) {
+    if (descA.empty() || descB.empty()) return {};
+    TransientScope transients(this);
+
+    uint32_t countA = descA.size() / 128;
+    uint32_t countB = descB.size() / 128;
+
+    // Bytes are already in the shader's packed u32 layout; upload as-is.
+    size_t sizeA = descA.size();
+    size_t sizeB = descB.size();
+    wgpu::Buffer bufA = transient_pool_.Acquire(sizeA, wgpu::BufferUsage::Storage | wgpu::BufferUsage::CopyDst);
+    wgpu::Buffer bufB = transient_pool_.Acquire(sizeB, wgpu::BufferUsage::Storage | wgpu::BufferUsage::CopyDst);
+    queue_.writeBuffer(bufA, 0, descA.data(), sizeA);
+    queue_.writeBuffer(bufB, 0, descB.data(), sizeB);
+
+    return MatchDescriptors(bufA, countA, bufB, countB, ratio_threshold, /*quantize=*/true);
+}
+
+std::vector<Match> SIFTMatcher::MatchDescriptors(wgpu::Buffer descA, uint32_t countA,
+                                                 wgpu::Buffer descB, uint32_t countB,
+                                                 float ratio_threshold,
+                                                 bool quantize,
+                                                 bool tiled) {
+    std::vector<Match> matches;
+    if (countA == 0 || countB == 0) return matches;
+    TransientScope transients(this);
+
+    if (tiled && quantize) {
+        // No quantized tiled kernel; packed u8 is already 4x lighter on bandwidth.
+        std::cerr << "[SIFTMatcher] Tiled matching is float-only, falling back to quantized kernel" << std::endl;
+        tiled = false;
+    }
+    wgpu::ComputePipeline pipe = quantize ? pipeline_quant_ : (tiled ? pipeline_tiled_ : pipeline_);
+    if (!pipe || !pipeline_compact_) {
+        std::cerr << "[SIFTMatcher] Pipeline not initialized" << std::endl;
+        return matches;
+    }
+
+    size_t descSize = quantize ? 32 * 4 : 128 * 4;
+    size_t sizeA = countA * descSize;
+    size_t sizeB = countB * descSize;
+
     size_t resSize = countA * sizeof(GPUMatchResult);
-    wgpu::Buffer bufRes = createBuffer(resSize, wgpu::BufferUsage::Storage | wgpu::BufferUsage::CopySrc);
+    wgpu::Buffer bufRes = transient_pool_.Acquire(resSize, wgpu::BufferUsage::Storage | wgpu::BufferUsage::CopySrc);
     uint32_t params[] = {countA, countB, 0, 0};
-    wgpu::Buffer bufParams = createBuffer(16, wgpu::BufferUsage::Uniform | wgpu::BufferUsage::CopyDst);
+    wgpu::Buffer bufParams = transient_pool_.Acquire(16, wgpu::BufferUsage::Uniform | wgpu::BufferUsage::CopyDst);
     queue_.writeBuffer(bufParams, 0, params, 16);
 
     wgpu::BindGroupEntry entries[4];
     entries[0].binding = 0; entries[0].buffer = bufParams; entries[0].size = 16;
-    entries[1].binding = 1; entries[1].buffer = bufA; entries[1].size = sizeA;
-    entries[2].binding = 2; entries[2].buffer = bufB; entries[2].size = sizeB;
+    entries[1].binding = 1; entries[1].buffer = descA; entries[1].size = sizeA;
+    entries[2].binding = 2; entries[2].buffer = descB; entries[2].size = sizeB;
     entries[3].binding = 3; entries[3].buffer = bufRes; entries[3].size = resSize;
     wgpu::BindGroupDescriptor bgd = {};
     bgd.layout = pipe.getBindGroupLayout(0);
     bgd.entryCount = 4; bgd.entries = entries;
     wgpu::BindGroup bg = device_.createBindGroup(bgd);
 
+    // Ratio test + compaction run on the GPU (matcher_compact.wgsl), so only
+    // the surviving matches cross the bus instead of countA full results.
+    size_t compactSize = 16 + (size_t)countA * sizeof(GPUCompactMatch);
+    wgpu::Buffer bufCompact = transient_pool_.Acquire(compactSize, wgpu::BufferUsage::Storage | wgpu::BufferUsage::CopySrc | wgpu::BufferUsage::CopyDst);
+    struct { uint32_t countA; uint32_t pad1; float ratioSq; float pad2; } cparams =
+        { countA, 0, ratio_threshold * ratio_threshold, 0 };
+    wgpu::Buffer bufCParams = transient_pool_.Acquire(16, wgpu::BufferUsage::Uniform | wgpu::BufferUsage::CopyDst);
+    queue_.writeBuffer(bufCParams, 0, &cparams, 16);
+    uint32_t zero = 0;
+    queue_.writeBuffer(bufCompact, 0, &zero, 4);
+
+    wgpu::BindGroupEntry centries[3];
+    centries[0].binding = 0; centries[0].buffer = bufCParams; centries[0].size = 16;
+    centries[1].binding = 1; centries[1].buffer = bufRes; centries[1].size = resSize;
+    centries[2].binding = 2; centries[2].buffer = bufCompact; centries[2].size = compactSize;
+    wgpu::BindGroupDescriptor cbgd = {};
+    cbgd.layout = pipeline_compact_.getBindGroupLayout(0);
+    cbgd.entryCount = 3; cbgd.entries = centries;
+    wgpu::BindGroup cbg = device_.createBindGroup(cbgd);
+
     wgpu::CommandEncoder enc = device_.createCommandEncoder();
     wgpu::ComputePassEncoder pass = enc.beginComputePass();
     pass.setPipeline(pipe); pass.setBindGroup(0, bg, 0, nullptr);
     pass.dispatchWorkgroups((countA + 63) / 64, 1, 1);
     pass.end();
-    wgpu::Buffer readBuf = createBuffer(resSize, wgpu::BufferUsage::MapRead | wgpu::BufferUsage::CopyDst);
-    enc.copyBufferToBuffer(bufRes, 0, readBuf, 0, resSize);
+    wgpu::ComputePassEncoder cpass = enc.beginComputePass();
+    cpass.setPipeline(pipeline_compact_); cpass.setBindGroup(0, cbg, 0, nullptr);
+    cpass.dispatchWorkgroups((countA + 63) / 64, 1, 1);
+    cpass.end();
+
+    // Read the survivor count first, then just count * 16 bytes of matches.
+    wgpu::Buffer readBuf = AcquireReadbackStaging(compactSize);
+    enc.copyBufferToBuffer(bufCompact, 0, readBuf, 0, 4);
     wgpu::CommandBuffer cmd = enc.finish();
     queue_.submit(1, &cmd);
 
+    return ReadbackCompactMatches(bufCompact, countA);
+}
+
+// Reads a CompactMatchList whose count was already copied into the staging
+// buffer by the caller's submit: maps the count, then copies and maps only
+// count * 16 bytes of matches.
+std::vector<Match> SIFTMatcher::ReadbackCompactMatches(wgpu::Buffer bufCompact, uint32_t maxCount) {
+    std::vector<Match> matches;
+    wgpu::Buffer readBuf = readback_staging_;
+
     bool done = false;
     wgpu::BufferMapCallbackInfo ci = {};
     ci.mode = wgpu::CallbackMode::AllowSpontaneous; ci.userdata1 = &done;
     ci.callback = [](WGPUMapAsyncStatus, WGPUStringView, void* u1, void*) { *(bool*)u1 = true; };
-    readBuf.mapAsync(wgpu::MapMode::Read, 0, resSize, ci);
-    while(!done) device_.poll(false, nullptr);
-    const GPUMatchResult* gpuRes = (const GPUMatchResult*)readBuf.getConstMappedRange(0, resSize);
-    float ratioSq = ratio_threshold * ratio_threshold;
-    for (uint32_t i = 0; i < countA; ++i) {
-        if (gpuRes[i].bestIdx >= 0 && gpuRes[i].bestDistSq < ratioSq * gpuRes[i].secondDistSq) {
-            Match m; m.queryIdx = i; m.trainIdx = gpuRes[i].bestIdx; m.distance = sqrt(gpuRes[i].bestDistSq);
-            matches.push_back(m);
-        }
+    readBuf.mapAsync(wgpu::MapMode::Read, 0, 4, ci);
+    while(!done) device_.poll(true, nullptr);
+    uint32_t matchCount = *(const uint32_t*)readBuf.getConstMappedRange(0, 4);
+    readBuf.unmap();
+    if (matchCount > maxCount) matchCount = maxCount;
+    if (matchCount == 0) return matches;
+
+    size_t matchBytes = (size_t)matchCount * sizeof(GPUCompactMatch);
+    wgpu::CommandEncoder enc = device_.createCommandEncoder();
+    enc.copyBufferToBuffer(bufCompact, 16, readBuf, 0, matchBytes);
+    wgpu::CommandBuffer cmd = enc.finish();
+    queue_.submit(1, &cmd);
+    done = false;
+    readBuf.mapAsync(wgpu::MapMode::Read, 0, matchBytes, ci);
+    while(!done) device_.poll(true, nullptr);
+    const GPUCompactMatch* gpuMatches = (const GPUCompactMatch*)readBuf.getConstMappedRange(0, matchBytes);
+    matches.reserve(matchCount);
+    for (uint32_t i = 0; i < matchCount; ++i) {
+        Match m; m.queryIdx = gpuMatches[i].queryIdx; m.trainIdx = gpuMatches[i].trainIdx;
+        m.distance = sqrt(gpuMatches[i].distSq);
+        matches.push_back(m);
     }
     readBuf.unmap();
     return matches;
 }
 
+std::vector<Match> SIFTMatcher::MatchCrossCheck(const std::vector<float>& descA,
+                                                const std::vector<float>& descB,
+                                                float ratio_threshold) {
+    std::vector<Match> matches;
+    if (descA.empty() || descB.empty()) return matches;
+    TransientScope transients(this);
+    if (!pipeline_ || !pipeline_cross_check_) {
+        std::cerr << "[SIFTMatcher] Pipeline not initialized" << std::endl;
+        return matches;
+    }
+
+    uint32_t countA = descA.size() / 128;
+    uint32_t countB = descB.size() / 128;
+    size_t sizeA = descA.size() * 4, sizeB = descB.size() * 4;
+    wgpu::Buffer bufA = transient_pool_.Acquire(sizeA, wgpu::BufferUsage::Storage | wgpu::BufferUsage::CopyDst);
+    wgpu::Buffer bufB = transient_pool_.Acquire(sizeB, wgpu::BufferUsage::Storage | wgpu::BufferUsage::CopyDst);
+    queue_.writeBuffer(bufA, 0, descA.data(), sizeA);
+    queue_.writeBuffer(bufB, 0, descB.data(), sizeB);
+
+    // Both match directions plus the mutual-best filter go into one command
+    // buffer; neither direction's full result array ever leaves the GPU.
+    size_t resSizeAB = countA * sizeof(GPUMatchResult);
+    size_t resSizeBA = countB * sizeof(GPUMatchResult);
+    wgpu::Buffer bufResAB = transient_pool_.Acquire(resSizeAB, wgpu::BufferUsage::Storage);
+    wgpu::Buffer bufResBA = transient_pool_.Acquire(resSizeBA, wgpu::BufferUsage::Storage);
+
+    uint32_t paramsAB[] = {countA, countB, 0, 0};
+    uint32_t paramsBA[] = {countB, countA, 0, 0};
+    wgpu::Buffer bufParamsAB = transient_pool_.Acquire(16, wgpu::BufferUsage::Uniform | wgpu::BufferUsage::CopyDst);
+    wgpu::Buffer bufParamsBA = transient_pool_.Acquire(16, wgpu::BufferUsage::Uniform | wgpu::BufferUsage::CopyDst);
+    queue_.writeBuffer(bufParamsAB, 0, paramsAB, 16);
+    queue_.writeBuffer(bufParamsBA, 0, paramsBA, 16);
+
+    auto make_match_bg = [&](wgpu::Buffer params, wgpu::Buffer dQ, size_t sQ,
+                             wgpu::Buffer dT, size_t sT, wgpu::Buffer res, size_t sRes) {
+        wgpu::BindGroupEntry entries[4];
+        entries[0].binding = 0; entries[0].buffer = params; entries[0].size = 16;
+        entries[1].binding = 1; entries[1].buffer = dQ; entries[1].size = sQ;
+        entries[2].binding = 2; entries[2].buffer = dT; entries[2].size = sT;
+        entries[3].binding = 3; entries[3].buffer = res; entries[3].size = sRes;
+        wgpu::BindGroupDescriptor bgd = {};
+        bgd.layout = pipeline_.getBindGroupLayout(0);
+        bgd.entryCount = 4; bgd.entries = entries;
+        return device_.createBindGroup(bgd);
+    };
+    wgpu::BindGroup bgAB = make_match_bg(bufParamsAB, bufA, sizeA, bufB, sizeB, bufResAB, resSizeAB);
+    wgpu::BindGroup bgBA = make_match_bg(bufParamsBA, bufB, sizeB, bufA, sizeA, bufResBA, resSizeBA);
+
+    size_t compactSize = 16 + (size_t)countA * sizeof(GPUCompactMatch);
+    wgpu::Buffer bufCompact = transient_pool_.Acquire(compactSize, wgpu::BufferUsage::Storage | wgpu::BufferUsage::CopySrc | wgpu::BufferUsage::CopyDst);
+    struct { uint32_t countA; uint32_t pad1; float ratioSq; float pad2; } cparams =
+        { countA, 0, ratio_threshold * ratio_threshold, 0 };
+    wgpu::Buffer bufCParams = transient_pool_.Acquire(16, wgpu::BufferUsage::Uniform | wgpu::BufferUsage::CopyDst);
+    queue_.writeBuffer(bufCParams, 0, &cparams, 16);
+    uint32_t zero = 0;
+    queue_.writeBuffer(bufCompact, 0, &zero, 4);
+
+    wgpu::BindGroupEntry xentries[4];
+    xentries[0].binding = 0; xentries[0].buffer = bufCParams; xentries[0].size = 16;
+    xentries[1].binding = 1; xentries[1].buffer = bufResAB; xentries[1].size = resSizeAB;
+    xentries[2].binding = 2; xentries[2].buffer = bufResBA; xentries[2].size = resSizeBA;
+    xentries[3].binding = 3; xentries[3].buffer = bufCompact; xentries[3].size = compactSize;
+    wgpu::BindGroupDescriptor xbgd = {};
+    xbgd.layout = pipeline_cross_check_.getBindGroupLayout(0);
+    xbgd.entryCount = 4; xbgd.entries = xentries;
+    wgpu::BindGroup xbg = device_.createBindGroup(xbgd);
+
+    wgpu::CommandEncoder enc = device_.createCommandEncoder();
+    wgpu::ComputePassEncoder pass = enc.beginComputePass();
+    pass.setPipeline(pipeline_);
+    pass.setBindGroup(0, bgAB, 0, nullptr);
+    pass.dispatchWorkgroups((countA + 63) / 64, 1, 1);
+    pass.setBindGroup(0, bgBA, 0, nullptr);
+    pass.dispatchWorkgroups((countB + 63) / 64, 1, 1);
+    pass.end();
+    wgpu::ComputePassEncoder xpass = enc.beginComputePass();
+    xpass.setPipeline(pipeline_cross_check_); xpass.setBindGroup(0, xbg, 0, nullptr);
+    xpass.dispatchWorkgroups((countA + 63) / 64, 1, 1);
+    xpass.end();
+
+    wgpu::Buffer readBuf = AcquireReadbackStaging(compactSize);
+    enc.copyBufferToBuffer(bufCompact, 0, readBuf, 0, 4);
+    wgpu::CommandBuffer cmd = enc.finish();
+    queue_.submit(1, &cmd);
+
+    return ReadbackCompactMatches(bufCompact, countA);
+}
+
+void SIFTMatcher::BuildIndex(const std::vector<float>& library,
+                             int num_cells,
+                             int kmeans_iterations) {
+    index_ = IVFIndex();
+    if (library.empty() || !pipeline_ivf_assign_) {
+        if (!pipeline_ivf_assign_) std::cerr << "[SIFTMatcher] Pipeline not initialized" << std::endl;
+        return;
+    }
+    TransientScope transients(this);
+
+    uint32_t count = library.size() / 128;
+    uint32_t cells = (uint32_t)std::max(1, std::min(num_cells, (int)count));
+
+    // Deterministic init: every (count/cells)-th descriptor seeds a centroid.
+    std::vector<float> centroids(cells * 128);
+    for (uint32_t c = 0; c < cells; ++c) {
+        uint32_t src = (uint32_t)((uint64_t)c * count / cells);
+        std::memcpy(&centroids[c * 128], &library[src * 128], 128 * sizeof(float));
+    }
+
+    size_t libSize = library.size() * 4;
+    size_t centSize = centroids.size() * 4;
+    size_t assignSize = (size_t)count * 4;
+    wgpu::Buffer bufLib = transient_pool_.Acquire(libSize, wgpu::BufferUsage::Storage | wgpu::BufferUsage::CopyDst);
+    wgpu::Buffer bufAssign = transient_pool_.Acquire(assignSize, wgpu::BufferUsage::Storage | wgpu::BufferUsage::CopySrc);
+    queue_.writeBuffer(bufLib, 0, library.data(), libSize);
+
+    // Centroids persist as part of the index; the k-means loop rewrites them
+    // in place each iteration.
+    index_.centroids = createBuffer(centSize, wgpu::BufferUsage::Storage | wgpu::BufferUsage::CopyDst);
+
+    uint32_t params[] = {count, cells, 0, 0};
+    wgpu::Buffer bufParams = transient_pool_.Acquire(16, wgpu::BufferUsage::Uniform | wgpu::BufferUsage::CopyDst);
+    queue_.writeBuffer(bufParams, 0, params, 16);
+
+    wgpu::BindGroupEntry entries[4];
+    entries[0].binding = 0; entries[0].buffer = bufParams; entries[0].size = 16;
+    entries[1].binding = 1; entries[1].buffer = bufLib; entries[1].size = libSize;
+    entries[2].binding = 2; entries[2].buffer = index_.centroids; entries[2].size = centSize;
+    entries[3].binding = 3; entries[3].buffer = bufAssign; entries[3].size = assignSize;
+    wgpu::BindGroupDescriptor bgd = {};
+    bgd.layout = pipeline_ivf_assign_.getBindGroupLayout(0);
+    bgd.entryCount = 4; bgd.entries = entries;
+    wgpu::BindGroup bg = device_.createBindGroup(bgd);
+
+    // Lloyd iterations: assignment on the GPU, mean update on the host from
+    // the read-back assignments. The last iteration skips the update so the
+    // stored cell lists match the stored centroids.
+    std::vector<uint32_t> assignments(count);
+    int iterations = std::max(1, kmeans_iterations);
+    for (int iter = 0; iter < iterations; ++iter) {
+        queue_.writeBuffer(index_.centroids, 0, centroids.data(), centSize);
+
+        wgpu::CommandEncoder enc = device_.createCommandEncoder();
+        wgpu::ComputePassEncoder pass = enc.beginComputePass();
+        pass.setPipeline(pipeline_ivf_assign_); pass.setBindGroup(0, bg, 0, nullptr);
+        pass.dispatchWorkgroups((count + 63) / 64, 1, 1);
+        pass.end();
+        wgpu::Buffer readBuf = AcquireReadbackStaging(assignSize);
+        enc.copyBufferToBuffer(bufAssign, 0, readBuf, 0, assignSize);
+        wgpu::CommandBuffer cmd = enc.finish();
+        queue_.submit(1, &cmd);
+
+        bool done = false;
+        wgpu::BufferMapCallbackInfo ci = {};
+        ci.mode = wgpu::CallbackMode::AllowSpontaneous; ci.userdata1 = &done;
+        ci.callback = [](WGPUMapAsyncStatus, WGPUStringView, void* u1, void*) { *(bool*)u1 = true; };
+        readBuf.mapAsync(wgpu::MapMode::Read, 0, assignSize, ci);
+        while (!done) device_.poll(true, nullptr);
+        std::memcpy(assignments.data(), readBuf.getConstMappedRange(0, assignSize), assignSize);
+        readBuf.unmap();
+
+        if (iter == iterations - 1) break;
+        std::vector<double> sums(cells * 128, 0.0);
+        std::vector<uint32_t> sizes(cells, 0);
+        for (uint32_t i = 0; i < count; ++i) {
+            uint32_t c = assignments[i];
+            sizes[c]++;
+            for (int k = 0; k < 128; ++k) sums[c * 128 + k] += library[i * 128 + k];
+        }
+        for (uint32_t c = 0; c < cells; ++c) {
+            if (sizes[c] == 0) continue;  // Empty cell keeps its old centroid
+            for (int k = 0; k < 128; ++k) centroids[c * 128 + k] = (float)(sums[c * 128 + k] / sizes[c]);
+        }
+    }
+
+    // CSR cell lists: offsets, original indices per slot, and the library
+    // reordered by cell so each probe scans contiguous memory.
+    std::vector<uint32_t> offsets(cells + 1, 0);
+    for (uint32_t i = 0; i < count; ++i) offsets[assignments[i] + 1]++;
+    for (uint32_t c = 0; c < cells; ++c) offsets[c + 1] += offsets[c];
+    std::vector<uint32_t> cursor(offsets.begin(), offsets.end() - 1);
+    std::vector<uint32_t> cell_entries(count);
+    std::vector<float> reordered(library.size());
+    for (uint32_t i = 0; i < count; ++i) {
+        uint32_t slot = cursor[assignments[i]]++;
+        cell_entries[slot] = i;
+        std::memcpy(&reordered[slot * 128], &library[i * 128], 128 * sizeof(float));
+    }
+
+    index_.count = count;
+    index_.cells = cells;
+    index_.cell_offsets = createBuffer(offsets.size() * 4, wgpu::BufferUsage::Storage | wgpu::BufferUsage::CopyDst);
+    index_.cell_entries = createBuffer(assignSize, wgpu::BufferUsage::Storage | wgpu::BufferUsage::CopyDst);
+    index_.descriptors = createBuffer(libSize, wgpu::BufferUsage::Storage | wgpu::BufferUsage::CopyDst);
+    queue_.writeBuffer(index_.cell_offsets, 0, offsets.data(), offsets.size() * 4);
+    queue_.writeBuffer(index_.cell_entries, 0, cell_entries.data(), assignSize);
+    queue_.writeBuffer(index_.descriptors, 0, reordered.data(), libSize);
+}
+
+std::vector<Match> SIFTMatcher::MatchIndexed(const std::vector<float>& descQ,
+                                             float ratio_threshold,
+                                             int nprobe) {
+    std::vector<Match> matches;
+    if (descQ.empty()) return matches;
+    if (index_.count == 0) {
+        std::cerr << "[SIFTMatcher] MatchIndexed called without BuildIndex" << std::endl;
+        return matches;
+    }
+    if (!pipeline_ivf_ || !pipeline_compact_) {
+        std::cerr << "[SIFTMatcher] Pipeline not initialized" << std::endl;
+        return matches;
+    }
+    TransientScope transients(this);
+
+    uint32_t countQ = descQ.size() / 128;
+    size_t sizeQ = descQ.size() * 4;
+    wgpu::Buffer bufQ = transient_pool_.Acquire(sizeQ, wgpu::BufferUsage::Storage | wgpu::BufferUsage::CopyDst);
+    queue_.writeBuffer(bufQ, 0, descQ.data(), sizeQ);
+
+    size_t resSize = countQ * sizeof(GPUMatchResult);
+    wgpu::Buffer bufRes = transient_pool_.Acquire(resSize, wgpu::BufferUsage::Storage | wgpu::BufferUsage::CopySrc);
+    uint32_t params[] = {countQ, index_.cells, (uint32_t)std::max(1, nprobe), 0};
+    wgpu::Buffer bufParams = transient_pool_.Acquire(16, wgpu::BufferUsage::Uniform | wgpu::BufferUsage::CopyDst);
+    queue_.writeBuffer(bufParams, 0, params, 16);
+
+    wgpu::BindGroupEntry entries[7];
+    entries[0].binding = 0; entries[0].buffer = bufParams; entries[0].size = 16;
+    entries[1].binding = 1; entries[1].buffer = bufQ; entries[1].size = sizeQ;
+    entries[2].binding = 2; entries[2].buffer = index_.centroids; entries[2].size = (size_t)index_.cells * 128 * 4;
+    entries[3].binding = 3; entries[3].buffer = index_.cell_offsets; entries[3].size = ((size_t)index_.cells + 1) * 4;
+    entries[4].binding = 4; entries[4].buffer = index_.cell_entries; entries[4].size = (size_t)index_.count * 4;
+    entries[5].binding = 5; entries[5].buffer = index_.descriptors; entries[5].size = (size_t)index_.count * 128 * 4;
+    entries[6].binding = 6; entries[6].buffer = bufRes; entries[6].size = resSize;
+    wgpu::BindGroupDescriptor bgd = {};
+    bgd.layout = pipeline_ivf_.getBindGroupLayout(0);
+    bgd.entryCount = 7; bgd.entries = entries;
+    wgpu::BindGroup bg = device_.createBindGroup(bgd);
+
+    // Same ratio-test + compaction tail as the brute-force path: the probe
+    // kernel writes MatchResult per query, so matcher_compact.wgsl is reused.
+    size_t compactSize = 16 + (size_t)countQ * sizeof(GPUCompactMatch);
+    wgpu::Buffer bufCompact = transient_pool_.Acquire(compactSize, wgpu::BufferUsage::Storage | wgpu::BufferUsage::CopySrc | wgpu::BufferUsage::CopyDst);
+    struct { uint32_t countA; uint32_t pad1; float ratioSq; float pad2; } cparams =
+        { countQ, 0, ratio_threshold * ratio_threshold, 0 };
+    wgpu::Buffer bufCParams = transient_pool_.Acquire(16, wgpu::BufferUsage::Uniform | wgpu::BufferUsage::CopyDst);
+    queue_.writeBuffer(bufCParams, 0, &cparams, 16);
+    uint32_t zero = 0;
+    queue_.writeBuffer(bufCompact, 0, &zero, 4);
+
+    wgpu::BindGroupEntry centries[3];
+    centries[0].binding = 0; centries[0].buffer = bufCParams; centries[0].size = 16;
+    centries[1].binding = 1; centries[1].buffer = bufRes; centries[1].size = resSize;
+    centries[2].binding = 2; centries[2].buffer = bufCompact; centries[2].size = compactSize;
+    wgpu::BindGroupDescriptor cbgd = {};
+    cbgd.layout = pipeline_compact_.getBindGroupLayout(0);
+    cbgd.entryCount = 3; cbgd.entries = centries;
+    wgpu::BindGroup cbg = device_.createBindGroup(cbgd);
+
+    wgpu::CommandEncoder enc = device_.createCommandEncoder();
+    wgpu::ComputePassEncoder pass = enc.beginComputePass();
+    pass.setPipeline(pipeline_ivf_); pass.setBindGroup(0, bg, 0, nullptr);
+    pass.dispatchWorkgroups((countQ + 63) / 64, 1, 1);
+    pass.end();
+    wgpu::ComputePassEncoder cpass = enc.beginComputePass();
+    cpass.setPipeline(pipeline_compact_); cpass.setBindGroup(0, cbg, 0, nullptr);
+    cpass.dispatchWorkgroups((countQ + 63) / 64, 1, 1);
+    cpass.end();
+
+    wgpu::Buffer readBuf = AcquireReadbackStaging(compactSize);
+    enc.copyBufferToBuffer(bufCompact, 0, readBuf, 0, 4);
+    wgpu::CommandBuffer cmd = enc.finish();
+    queue_.submit(1, &cmd);
+
+    return ReadbackCompactMatches(bufCompact, countQ);
+}
+
 std::vector<Match> SIFTMatcher::MatchGuided(const std::vector<float>& descA, const std::vector<float>& kpsA,
                                             const std::vector<float>& descB, const std::vector<float>& kpsB,
                                             const std::vector<float>& F,
                                             float threshold, float ratio_threshold) {
     std::vector<Match> matches;
     if (descA.empty() || descB.empty() || !pipeline_guided_) return matches;
+    TransientScope transients(this);
     uint32_t countA = descA.size() / 128;
     uint32_t countB = descB.size() / 128;
     size_t sizeA = descA.size() * 4, sizeB = descB.size() * 4;
     size_t sizeKpA = kpsA.size() * 4, sizeKpB = kpsB.size() * 4;
-    wgpu::Buffer bDA = createBuffer(sizeA, wgpu::BufferUsage::Storage | wgpu::BufferUsage::CopyDst);
-    wgpu::Buffer bDB = createBuffer(sizeB, wgpu::BufferUsage::Storage | wgpu::BufferUsage::CopyDst);
-    wgpu::Buffer bKA = createBuffer(sizeKpA, wgpu::BufferUsage::Storage | wgpu::BufferUsage::CopyDst);
-    wgpu::Buffer bKB = createBuffer(sizeKpB, wgpu::BufferUsage::Storage | wgpu::BufferUsage::CopyDst);
+    wgpu::Buffer bDA = transient_pool_.Acquire(sizeA, wgpu::BufferUsage::Storage | wgpu::BufferUsage::CopyDst);
+    wgpu::Buffer bDB = transient_pool_.Acquire(sizeB, wgpu::BufferUsage::Storage | wgpu::BufferUsage::CopyDst);
+    wgpu::Buffer bKA = transient_pool_.Acquire(sizeKpA, wgpu::BufferUsage::Storage | wgpu::BufferUsage::CopyDst);
+    wgpu::Buffer bKB = transient_pool_.Acquire(sizeKpB, wgpu::BufferUsage::Storage | wgpu::BufferUsage::CopyDst);
     queue_.writeBuffer(bDA, 0, descA.data(), sizeA); queue_.writeBuffer(bDB, 0, descB.data(), sizeB);
     queue_.writeBuffer(bKA, 0, kpsA.data(), sizeKpA); queue_.writeBuffer(bKB, 0, kpsB.data(), sizeKpB);
+    return MatchGuided(bDA, bKA, countA, bDB, bKB, countB, F, threshold, ratio_threshold);
+}
+
+std::vector<Match> SIFTMatcher::MatchGuided(wgpu::Buffer descA, wgpu::Buffer kpsA, uint32_t countA,
+                                            wgpu::Buffer descB, wgpu::Buffer kpsB, uint32_t countB,
+                                            const std::vector<float>& F,
+                                            float threshold, float ratio_threshold) {
+    std::vector<Match> matches;
+    if (countA == 0 || countB == 0 || !pipeline_guided_) return matches;
+    TransientScope transients(this);
+    size_t sizeA = countA * 128 * 4, sizeB = countB * 128 * 4;
+    size_t sizeKpA = countA * 2 * 4, sizeKpB = countB * 2 * 4;
+    wgpu::Buffer bDA = descA, bDB = descB, bKA = kpsA, bKB = kpsB;
     size_t resSize = countA * sizeof(GPUMatchResult);
-    wgpu::Buffer bR = createBuffer(resSize, wgpu::BufferUsage::Storage | wgpu::BufferUsage::CopySrc);
+    wgpu::Buffer bR = transient_pool_.Acquire(resSize, wgpu::BufferUsage::Storage | wgpu::BufferUsage::CopySrc);
     struct { uint32_t cA, cB; float t; uint32_t p; float col0[4], col1[4], col2[4]; } p;
     p.cA = countA; p.cB = countB; p.t = threshold; p.p = 0;
     p.col0[0] = F[0]; p.col0[1] = F[3]; p.col0[2] = F[6]; p.col0[3] = 0;
     p.col1[0] = F[1]; p.col1[1] = F[4]; p.col1[2] = F[7]; p.col1[3] = 0;
     p.col2[0] = F[2]; p.col2[1] = F[5]; p.col2[2] = F[8]; p.col2[3] = 0;
-    wgpu::Buffer bP = createBuffer(sizeof(p), wgpu::BufferUsage::Uniform | wgpu::BufferUsage::CopyDst);
+    wgpu::Buffer bP = transient_pool_.Acquire(sizeof(p), wgpu::BufferUsage::Uniform | wgpu::BufferUsage::CopyDst);
     queue_.writeBuffer(bP, 0, &p, sizeof(p));
     wgpu::BindGroupEntry e[6];
     e[0].binding = 0; e[0].buffer = bP; e[0].size = sizeof(p);
@@ -198,7 +643,7 @@ std::vector<Match> SIFTMatcher::MatchGuided(const std::vector<float>& descA, con
     pass.setPipeline(pipeline_guided_); pass.setBindGroup(0, bg, 0, nullptr);
     pass.dispatchWorkgroups((countA + 63) / 64, 1, 1);
     pass.end();
-    wgpu::Buffer readBuf = createBuffer(resSize, wgpu::BufferUsage::MapRead | wgpu::BufferUsage::CopyDst);
+    wgpu::Buffer readBuf = AcquireReadbackStaging(resSize);
     enc.copyBufferToBuffer(bR, 0, readBuf, 0, resSize);
     wgpu::CommandBuffer cmd = enc.finish();
     queue_.submit(1, &cmd);
@@ -206,7 +651,7 @@ std::vector<Match> SIFTMatcher::MatchGuided(const std::vector<float>& descA, con
     wgpu::BufferMapCallbackInfo cbi = {}; cbi.mode = wgpu::CallbackMode::AllowSpontaneous; cbi.userdata1 = &done;
     cbi.callback = [](WGPUMapAsyncStatus, WGPUStringView, void* u1, void*) { *(bool*)u1 = true; };
     readBuf.mapAsync(wgpu::MapMode::Read, 0, resSize, cbi);
-    while(!done) device_.poll(false, nullptr);
+    while(!done) device_.poll(true, nullptr);
     const GPUMatchResult* gpuRes = (const GPUMatchResult*)readBuf.getConstMappedRange(0, resSize);
     float ratioSq = ratio_threshold * ratio_threshold;
     for (uint32_t i = 0; i < countA; ++i) {
@@ -4,6 +4,8 @@
 #include <vector>
 #include <webgpu/webgpu.hpp>
 
+#include "buffer_pool.h"
+
 struct Match {
     int trainIdx; // Index in descriptorsB
     int queryIdx; // Index in descriptorsA
@@ -19,11 +21,40 @@ class SIFTMatcher {
     
     // Returns indices in descB that match descA
     // ratio_threshold: Lowe's ratio test (e.g. 0.75)
-    std::vector<Match> MatchDescriptors(const std::vector<float>& descA, 
-                                        const std::vector<float>& descB, 
+    // tiled: use the shared-memory tiled kernel (matcher_tiled.wgsl);
+    // recommended past ~20k descriptors per side. Float descriptors only.
+    std::vector<Match> MatchDescriptors(const std::vector<float>& descA,
+                                        const std::vector<float>& descB,
                                         float ratio_threshold = 0.75f,
-                                        bool quantize = false);
-    
+                                        bool quantize = false,
+                                        bool tiled = false);
+
+    // Quantized variant consuming packed uint8 descriptors directly (128
+    // bytes per descriptor, as produced by ReadbackDescriptorsQuantized) —
+    // no float expansion or re-packing on the host.
+    std::vector<Match> MatchDescriptors(const std::vector<uint8_t>& descA,
+                                        const std::vector<uint8_t>& descB,
+                                        float ratio_threshold = 0.75f);
+
+    // Symmetric cross-check matching: computes both directions in a single
+    // submit and returns only mutually-best matches (with the ratio test
+    // applied A->B), replacing the MatchDescriptors(A,B) + MatchDescriptors(B,A)
+    // + host intersection pattern.
+    std::vector<Match> MatchCrossCheck(const std::vector<float>& descA,
+                                       const std::vector<float>& descB,
+                                       float ratio_threshold = 0.75f);
+
+    // GPU-resident variant: matches descriptors already living on the GPU
+    // (e.g. SIFTPacked::GetDescriptorBuffer() from two detector instances)
+    // without the CPU round trip; only the match results are read back.
+    // Buffer layout must match the detector output: 128 f32 per descriptor,
+    // or 32 u32 (packed uint8) when quantize is set.
+    std::vector<Match> MatchDescriptors(wgpu::Buffer descA, uint32_t countA,
+                                        wgpu::Buffer descB, uint32_t countB,
+                                        float ratio_threshold = 0.75f,
+                                        bool quantize = false,
+                                        bool tiled = false);
+
     // Guided matching with F-matrix
     // keypoints are flattened [x0, y0, x1, y1...]
     // F is 3x3 array (row-major or col-major? standard is row-major usually but we pass as raw floats)
@@ -34,15 +65,86 @@ class SIFTMatcher {
                                    float threshold,
                                    float ratio_threshold = 0.75f);
 
+    // Builds a GPU-resident inverted-file (IVF) index over a library of
+    // float descriptors: k-means clusters them into num_cells coarse cells
+    // (assignment on the GPU, centroid update on the host) and stores the
+    // centroids plus per-cell descriptor lists on the device. The index
+    // persists until the next BuildIndex call and is reused across queries.
+    void BuildIndex(const std::vector<float>& library,
+                    int num_cells = 256,
+                    int kmeans_iterations = 10);
+
+    // Approximate matching against the library indexed by BuildIndex: each
+    // query scans only its nprobe nearest cells instead of the whole
+    // library. trainIdx values refer to the original library ordering.
+    // Recall is high (typically >95% of brute-force matches at nprobe=8)
+    // but not exact; use MatchDescriptors when exactness matters.
+    std::vector<Match> MatchIndexed(const std::vector<float>& descQ,
+                                    float ratio_threshold = 0.75f,
+                                    int nprobe = 8);
+
+    // GPU-resident variant of MatchGuided. Keypoint buffers use the same
+    // flattened [x0, y0, x1, y1...] f32 layout as the vector overload (note:
+    // this is not the detector's 32-byte keypoint record layout).
+    std::vector<Match> MatchGuided(wgpu::Buffer descA, wgpu::Buffer kpsA, uint32_t countA,
+                                   wgpu::Buffer descB, wgpu::Buffer kpsB, uint32_t countB,
+                                   const std::vector<float>& F,
+                                   float threshold,
+                                   float ratio_threshold = 0.75f);
+
  private:
     wgpu::Device device_;
     wgpu::Queue queue_;
     wgpu::ComputePipeline pipeline_;
     wgpu::ComputePipeline pipeline_quant_;
     wgpu::ComputePipeline pipeline_guided_; // New pipeline
-    
+    wgpu::ComputePipeline pipeline_tiled_;  // Shared-memory tiled kernel
+    wgpu::ComputePipeline pipeline_compact_; // GPU ratio test + match compaction
+    wgpu::ComputePipeline pipeline_cross_check_; // Mutual-best filter
+    wgpu::ComputePipeline pipeline_ivf_assign_; // K-means assignment (BuildIndex)
+    wgpu::ComputePipeline pipeline_ivf_;        // IVF probe + scan (MatchIndexed)
+
     wgpu::Buffer params_buf_;
-    
+
+    // IVF index built by BuildIndex. Unlike the transient pool these buffers
+    // persist across Match* calls; descriptors holds the library reordered by
+    // cell and cell_entries maps each slot back to its original index.
+    struct IVFIndex {
+        uint32_t count = 0;
+        uint32_t cells = 0;
+        wgpu::Buffer centroids;
+        wgpu::Buffer cell_offsets;  // cells + 1 u32, CSR layout
+        wgpu::Buffer cell_entries;
+        wgpu::Buffer descriptors;
+    };
+    IVFIndex index_;
+
+    // Reusable MapRead staging for match results, grown to the high-water
+    // mark so steady-state matching allocates no GPU buffers.
+    wgpu::Buffer readback_staging_;
+    size_t readback_staging_size_ = 0;
+    wgpu::Buffer AcquireReadbackStaging(size_t size);
+    std::vector<Match> ReadbackCompactMatches(wgpu::Buffer bufCompact, uint32_t maxCount);
+
+    // Per-call transient buffers (uploads, results, params uniforms) come
+    // from a pool instead of fresh allocations; the outermost public Match*
+    // call resets it, delegated inner overloads leave it alone.
+    BufferPool transient_pool_;
+    bool in_match_ = false;
+    struct TransientScope {
+        explicit TransientScope(SIFTMatcher* m) : m_(m), owns_(!m->in_match_) {
+            if (owns_) {
+                m_->in_match_ = true;
+                m_->transient_pool_.Reset();
+            }
+        }
+        ~TransientScope() {
+            if (owns_) m_->in_match_ = false;
+        }
+        SIFTMatcher* m_;
+        bool owns_;
+    };
+
     // Helpers
     wgpu::Buffer createBuffer(size_t size, wgpu::BufferUsage usage);
     std::string loadShader(const std::string& name); // Updated to take name
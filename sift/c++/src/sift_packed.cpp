@@ -1,8 +1,11 @@
 #include "sift_packed.h"
 #include "embedded_shaders.h"
 #include "utils.h"
+#include <algorithm>
+#include <fstream>
 #include <iostream>
 #include <cstdio>
+#include <cstring>
 #include <cmath>
 #include <vector>
 #include <webgpu/webgpu.h>
@@ -10,8 +13,7 @@
 // wgpu-native extension function
 extern "C" float wgpuQueueGetTimestampPeriod(WGPUQueue queue);
 
-constexpr int SIFTPacked::kNumOctaves;
-constexpr int SIFTPacked::kScalesPerOctave;
+constexpr int SIFTPacked::kMaxOctaves;
 constexpr float SIFTPacked::kSigmaBase;
 
 SIFTPacked::SIFTPacked() = default;
@@ -19,89 +21,206 @@ SIFTPacked::~SIFTPacked() = default;
 
 void SIFTPacked::Init(wgpu::Device device, const SIFTOptions& options) {
     SIFTBase::Init(device, options);
+    num_octaves_ = std::min(std::max(options_.numOctaves, 1), kMaxOctaves);
+    scales_per_octave_ = std::max(options_.scalesPerOctave, 1);
     InitPipelines();
     InitBuffers();
-
-    // Get timestamp period (wgpu-native extension)
-    // The cast to WGPUQueue is safe for the elie-michel wrapper
-    timestamp_period_ = wgpuQueueGetTimestampPeriod((WGPUQueue)queue_);
-    if (timestamp_period_ <= 0) timestamp_period_ = 1.0f;
 }
 
 std::string SIFTPacked::loadShader(const std::string& filename) {
     // Check if we need quantized descriptor
     std::string final_filename = filename;
-    if (filename == "descriptor.wgsl" && options_.quantizeDescriptors) {
-        final_filename = "descriptor_quantized.wgsl";
+    if (filename == "descriptor_binned.wgsl" && options_.quantizeDescriptors) {
+        final_filename = "descriptor_quantized_binned.wgsl";
+    }
+    if (filename == "grayscale.wgsl" && options_.grayscaleInput) {
+        final_filename = "grayscale_r8.wgsl"; // r8unorm Y-plane input, packing only
     }
 
     // Check embedded
-    std::string key = (final_filename == "prepare_dispatch.wgsl") ? final_filename : ("packed/" + final_filename);
+    bool is_common = (final_filename == "prepare_dispatch.wgsl" || final_filename == "bin_keypoints.wgsl" ||
+                      final_filename == "select_keypoints.wgsl");
+    std::string key = is_common ? final_filename : ("packed/" + final_filename);
     std::string code = shader_embed::GetShader(key);
-    if (!code.empty()) return code;
-
-    std::vector<std::string> search_paths;
-    if (final_filename == "prepare_dispatch.wgsl") {
-        search_paths = { "../../src/shaders/common/", "../src/shaders/common/", "src/shaders/common/" };
-    } else {
-        search_paths = { "../../src/shaders/detection/packed/", "../src/shaders/detection/packed/", "src/shaders/detection/packed/" };
+    if (code.empty()) {
+        std::vector<std::string> search_paths;
+        if (is_common) {
+            search_paths = { "../../src/shaders/common/", "../src/shaders/common/", "src/shaders/common/" };
+        } else {
+            search_paths = { "../../src/shaders/detection/packed/", "../src/shaders/detection/packed/", "src/shaders/detection/packed/" };
+        }
+        for (const auto& base : search_paths) {
+            try {
+                code = utils::readFile(base + final_filename);
+                break;
+            } catch (...) {}
+        }
     }
 
-    for (const auto& base : search_paths) {
-        try {
-            return utils::readFile(base + final_filename);
-        } catch (...) {}
+    // Half-precision pyramids: same kernels, storage-texture declarations
+    // retargeted at load time (the format only appears in the WGSL binding
+    // declarations; sampled texture_2d<f32> reads are format-agnostic).
+    if (options_.halfFloatPyramids) {
+        const std::string from = "rgba32float", to = "rgba16float";
+        for (size_t pos = code.find(from); pos != std::string::npos; pos = code.find(from, pos + to.size())) {
+            code.replace(pos, from.size(), to);
+        }
     }
-    return "";
+    return code;
 }
 
 void SIFTPacked::InitPipelines() {
-    auto create_compute_pipeline = [&](const std::string& shader_file, const std::string& entry_point = "main") {
+    // Shader compilation dominates cold start (hundreds of ms across these
+    // modules on the CLI batch jobs). wgpu-native does not expose the
+    // pipeline-cache extension yet, so the compiles can't be persisted
+    // across processes (the driver-level caches still help warm starts) —
+    // but they can overlap: createComputePipelineAsync hands each pipeline
+    // to the backend's compiler threads and we block once for all of them
+    // instead of once per pipeline.
+    struct PendingPipeline {
+        wgpu::ComputePipeline* target;
+        std::string name;
+        bool done = false;
+    };
+    std::vector<std::unique_ptr<PendingPipeline>> pending;
+
+    auto create_compute_pipeline = [&](wgpu::ComputePipeline* target, const std::string& shader_file,
+                                       const std::string& entry_point = "main",
+                                       const std::vector<wgpu::ConstantEntry>& constants = {}) {
         std::string code = loadShader(shader_file);
         wgpu::ShaderModule module = CreateShaderModule(code);
         wgpu::ComputePipelineDescriptor desc;
         desc.compute.module = module;
         desc.compute.entryPoint = wgpu::StringView(entry_point.c_str());
-        return device_.createComputePipeline(desc);
+        desc.compute.constantCount = constants.size();
+        desc.compute.constants = constants.data();
+
+        pending.push_back(std::unique_ptr<PendingPipeline>(new PendingPipeline{target, shader_file}));
+        PendingPipeline* p = pending.back().get();
+
+        wgpu::CreateComputePipelineAsyncCallbackInfo callbackInfo = {};
+        callbackInfo.mode = wgpu::CallbackMode::AllowSpontaneous;
+        callbackInfo.userdata1 = p;
+        callbackInfo.callback = [](WGPUCreatePipelineAsyncStatus status, WGPUComputePipeline pipeline,
+                                   WGPUStringView message, void* user1, void*) {
+            PendingPipeline* pp = (PendingPipeline*)user1;
+            if (status == WGPUCreatePipelineAsyncStatus_Success) {
+                *pp->target = pipeline;
+            } else {
+                std::cerr << "[SIFTPacked] Pipeline creation failed for " << pp->name;
+                if (message.data) std::cerr << ": " << std::string(message.data, message.length);
+                std::cerr << std::endl;
+            }
+            pp->done = true;
+        };
+        device_.createComputePipelineAsync(desc, callbackInfo);
+    };
+    auto constant = [](const char* key, double value) {
+        wgpu::ConstantEntry e = {};
+        e.key = wgpu::StringView(key);
+        e.value = value;
+        return e;
     };
+    // Pyramid-shape specialization (WGSL overrides), per deployment tier
+    std::vector<wgpu::ConstantEntry> scale_consts = { constant("SCALES_PER_OCTAVE", (double)scales_per_octave_) };
+    std::vector<wgpu::ConstantEntry> octave_consts = { constant("NUM_OCTAVES", (double)num_octaves_) };
 
-    pipeline_grayscale_ = create_compute_pipeline("grayscale.wgsl");
-    pipeline_blur_h_ = create_compute_pipeline("blur_horizontal.wgsl", "main");
-    pipeline_blur_v_ = create_compute_pipeline("blur_vertical.wgsl", "main");
-    pipeline_dog_ = create_compute_pipeline("dog.wgsl");
-    pipeline_downsample_ = create_compute_pipeline("downsample.wgsl");
-    pipeline_extrema_ = create_compute_pipeline("extrema.wgsl");
-    pipeline_orientation_ = create_compute_pipeline("orientation.wgsl");
-    pipeline_descriptor_ = create_compute_pipeline("descriptor.wgsl");
-    pipeline_prepare_dispatch_ = create_compute_pipeline("prepare_dispatch.wgsl");
+    create_compute_pipeline(&pipeline_grayscale_, "grayscale.wgsl");
+    create_compute_pipeline(&pipeline_blur_h_, "blur_horizontal.wgsl", "main");
+    create_compute_pipeline(&pipeline_blur_v_, "blur_vertical.wgsl", "main");
+    create_compute_pipeline(&pipeline_dog_, "dog.wgsl");
+    create_compute_pipeline(&pipeline_downsample_, "downsample.wgsl");
+    create_compute_pipeline(&pipeline_extrema_, "extrema.wgsl", "main", scale_consts);
+    create_compute_pipeline(&pipeline_orientation_, "orientation_binned.wgsl", "main", scale_consts);
+    create_compute_pipeline(&pipeline_descriptor_, "descriptor_binned.wgsl", "main", scale_consts);
+    create_compute_pipeline(&pipeline_bin_keypoints_, "bin_keypoints.wgsl", "main", octave_consts);
+    if (options_.maxKeypoints > 0) {
+        create_compute_pipeline(&pipeline_select_keypoints_, "select_keypoints.wgsl");
+    }
+
+    for (;;) {
+        bool all_done = true;
+        for (auto& p : pending) all_done = all_done && p->done;
+        if (all_done) break;
+        device_.poll(true, nullptr);
+    }
 }
 
 void SIFTPacked::InitBuffers() {
     size_t kp_size = 16 + kMaxKeypoints * 32;
     buffers_.keypoints = createBuffer(kp_size, wgpu::BufferUsage::Storage | wgpu::BufferUsage::CopySrc | wgpu::BufferUsage::CopyDst | wgpu::BufferUsage::Indirect);
-    
+
     size_t desc_elem_size = options_.quantizeDescriptors ? 32 * 4 : 128 * 4;
     size_t desc_size = kMaxKeypoints * desc_elem_size;
     buffers_.descriptors = createBuffer(desc_size, wgpu::BufferUsage::Storage | wgpu::BufferUsage::CopySrc | wgpu::BufferUsage::CopyDst);
 
-    buffers_.params16 = createBuffer(16, wgpu::BufferUsage::Uniform | wgpu::BufferUsage::CopyDst);
-    buffers_.params_extrema = createBuffer(24, wgpu::BufferUsage::Uniform | wgpu::BufferUsage::CopyDst);
-    
-    // Indirect dispatch buffer: 6 u32 values (orientation x,y,z + descriptor x,y,z)
-    buffers_.indirect_dispatch = createBuffer(24, wgpu::BufferUsage::Storage | wgpu::BufferUsage::Indirect | wgpu::BufferUsage::CopyDst);
+    // Indirect dispatch buffer: per-octave x,y,z triples, kMaxOctaves
+    // orientation entries followed by kMaxOctaves descriptor entries. Sized
+    // for kMaxOctaves so the layout is independent of the runtime octave count.
+    buffers_.indirect_dispatch = createBuffer(kMaxOctaves * 2 * 12, wgpu::BufferUsage::Storage | wgpu::BufferUsage::Indirect | wgpu::BufferUsage::CopyDst);
+
+    // Octave bins: counts/offsets/cursors header + one index per keypoint.
+    // CopySrc so the readback path can report per-octave fill levels.
+    buffers_.octave_bins = createBuffer(kMaxOctaves * 3 * 4 + kMaxKeypoints * 4, wgpu::BufferUsage::Storage | wgpu::BufferUsage::CopySrc);
+
+    // Top-K compaction target; the selected keypoints are copied back into
+    // buffers_.keypoints inside the frame's command buffer.
+    if (options_.maxKeypoints > 0) {
+        buffers_.keypoints_selected = createBuffer(kp_size, wgpu::BufferUsage::Storage | wgpu::BufferUsage::CopySrc);
+    }
+
+    // Per-frame uniform arena (one upload per frame, passes bind at offsets)
+    uniform_arena_ = createBuffer(kUniformArenaSize, wgpu::BufferUsage::Uniform | wgpu::BufferUsage::CopyDst);
+    uniform_arena_staging_.resize(kUniformArenaSize);
+
+    // Readback staging: allocated once here so steady-state detection never
+    // hits the driver allocator (fresh MapRead buffers showed up as
+    // multi-millisecond spikes in latency histograms).
+    kp_readback_staging_ = createBuffer(kp_size, wgpu::BufferUsage::MapRead | wgpu::BufferUsage::CopyDst);
+    desc_readback_staging_ = createBuffer(desc_size, wgpu::BufferUsage::MapRead | wgpu::BufferUsage::CopyDst);
 
-    // Timestamp Query
-    wgpu::QuerySetDescriptor qDesc;
-    qDesc.type = wgpu::QueryType::Timestamp;
-    qDesc.count = 7; // start, gray, pyr, ext, ori, desc, end
-    query_set_ = device_.createQuerySet(qDesc);
-    query_resolve_buf_ = createBuffer(7 * 8, wgpu::BufferUsage::QueryResolve | wgpu::BufferUsage::CopySrc);
-    query_result_buf_ = createBuffer(7 * 8, wgpu::BufferUsage::MapRead | wgpu::BufferUsage::CopyDst);
+    // Coarse stage timestamps (shared SIFTBase machinery)
+    InitStageTimestamps();
+
+    // Per-pass trace queries (separate from the coarse 7-entry stage set so
+    // the stage profiling keeps working with tracing off)
+    if (options_.enableTracing) {
+        wgpu::QuerySetDescriptor tDesc;
+        tDesc.type = wgpu::QueryType::Timestamp;
+        tDesc.count = kTraceMaxQueries;
+        trace_query_set_ = device_.createQuerySet(tDesc);
+        trace_resolve_buf_ = createBuffer(kTraceMaxQueries * 8, wgpu::BufferUsage::QueryResolve | wgpu::BufferUsage::CopySrc);
+        trace_result_buf_ = createBuffer(kTraceMaxQueries * 8, wgpu::BufferUsage::MapRead | wgpu::BufferUsage::CopyDst);
+    }
+}
+
+size_t SIFTPacked::AcquireUniformSlot(const void* data, size_t size) {
+    if (uniform_arena_cursor_ + kUniformSlotStride > kUniformArenaSize) {
+        std::cerr << "[SIFTPacked] Uniform arena overflow, pass params will be wrong" << std::endl;
+        uniform_arena_cursor_ = 0; // Keep going rather than crash
+    }
+    size_t offset = uniform_arena_cursor_;
+    std::memcpy(uniform_arena_staging_.data() + offset, data, size);
+    uniform_arena_cursor_ += kUniformSlotStride;
+    return offset;
 }
 
 void SIFTPacked::Resize(int w, int h) {
     if (pyramid_cache_ && pyramid_cache_->w == w && pyramid_cache_->h == h) return;
 
+    // Park the active cache (most recently used at the back) and see if this
+    // resolution is already warm; the cached bind groups stay valid because
+    // they reference the cache's own views plus the persistent shared buffers.
+    if (pyramid_cache_) pyramid_pool_.push_back(std::move(pyramid_cache_));
+    for (auto it = pyramid_pool_.begin(); it != pyramid_pool_.end(); ++it) {
+        if ((*it)->w == w && (*it)->h == h) {
+            pyramid_cache_ = std::move(*it);
+            pyramid_pool_.erase(it);
+            return;
+        }
+    }
+    if (pyramid_pool_.size() > kPyramidPoolCap) pyramid_pool_.erase(pyramid_pool_.begin());
+
     pyramid_cache_ = std::make_unique<PyramidCache>();
     pyramid_cache_->w = w;
     pyramid_cache_->h = h;
@@ -115,101 +234,236 @@ void SIFTPacked::Resize(int w, int h) {
         desc.size = { (uint32_t)width, (uint32_t)height, 1 };
         desc.sampleCount = 1;
         desc.mipLevelCount = 1;
-        desc.format = wgpu::TextureFormat::RGBA32Float; // Packed uses RGBA32Float for 4 pixels
+        desc.format = options_.halfFloatPyramids ? wgpu::TextureFormat::RGBA16Float
+                                                 : wgpu::TextureFormat::RGBA32Float; // Packed: 4 logical pixels per texel
         desc.usage = wgpu::TextureUsage::StorageBinding | wgpu::TextureUsage::TextureBinding | wgpu::TextureUsage::CopyDst; // Add CopyDst just in case
         return device_.createTexture(desc);
     };
 
+    wgpu::TextureDescriptor tdesc;
+    tdesc.size = { (uint32_t)w, (uint32_t)h, 1 };
+    tdesc.sampleCount = 1;
+    tdesc.mipLevelCount = 1;
+    tdesc.format = options_.grayscaleInput ? wgpu::TextureFormat::R8Unorm
+                                           : wgpu::TextureFormat::RGBA8Unorm;
+    tdesc.usage = wgpu::TextureUsage::TextureBinding | wgpu::TextureUsage::CopyDst | wgpu::TextureUsage::RenderAttachment;
+    pyramid_cache_->input_texture = device_.createTexture(tdesc);
+    pyramid_cache_->input_view = pyramid_cache_->input_texture.createView();
+
     pyramid_cache_->base_texture = create_tex(pw, ph);
     pyramid_cache_->temp_texture = create_tex(pw, ph);
+    pyramid_cache_->base_view = pyramid_cache_->base_texture.createView();
+    pyramid_cache_->temp_view = pyramid_cache_->temp_texture.createView();
 
     int curr_w = pw;
     int curr_h = ph;
 
-    for (int o = 0; o < kNumOctaves; ++o) {
+    for (int o = 0; o < num_octaves_; ++o) {
         pyramid_cache_->octave_sizes.push_back({curr_w, curr_h});
         std::vector<wgpu::Texture> gauss_octave;
         std::vector<wgpu::Texture> dog_octave;
+        std::vector<wgpu::TextureView> gauss_views;
+        std::vector<wgpu::TextureView> dog_views;
+
+        for (int s = 0; s < scales_per_octave_ + 3; ++s) {
+            gauss_octave.push_back(create_tex(curr_w, curr_h));
+            gauss_views.push_back(gauss_octave.back().createView());
+        }
+        for (int s = 0; s < scales_per_octave_ + 2; ++s) {
+            dog_octave.push_back(create_tex(curr_w, curr_h));
+            dog_views.push_back(dog_octave.back().createView());
+        }
 
-        for (int s = 0; s < kScalesPerOctave + 3; ++s) gauss_octave.push_back(create_tex(curr_w, curr_h));
-        for (int s = 0; s < kScalesPerOctave + 2; ++s) dog_octave.push_back(create_tex(curr_w, curr_h));
-        
         pyramid_cache_->gaussian_pyramid.push_back(gauss_octave);
         pyramid_cache_->dog_pyramid.push_back(dog_octave);
+        pyramid_cache_->gaussian_views.push_back(gauss_views);
+        pyramid_cache_->dog_views.push_back(dog_views);
 
         curr_w /= 2;
         curr_h /= 2;
     }
 }
 
+wgpu::BindGroup SIFTPacked::AcquirePassBindGroup(wgpu::ComputePipeline& pipeline, const wgpu::BindGroupEntry* entries, size_t count) {
+    if (pyramid_cache_->pass_bind_group_cursor < pyramid_cache_->pass_bind_groups.size()) {
+        return pyramid_cache_->pass_bind_groups[pyramid_cache_->pass_bind_group_cursor++];
+    }
+    wgpu::BindGroupDescriptor desc;
+    desc.layout = pipeline.getBindGroupLayout(0);
+    desc.entryCount = count;
+    desc.entries = entries;
+    wgpu::BindGroup bind = device_.createBindGroup(desc);
+    pyramid_cache_->pass_bind_groups.push_back(bind);
+    pyramid_cache_->pass_bind_group_cursor++;
+    return bind;
+}
+
 static volatile bool g_map_done = false;
 
-void SIFTPacked::WriteTimestamp(uint32_t index) {
-    wgpu::CommandEncoder enc = device_.createCommandEncoder();
+wgpu::ComputePassEncoder SIFTPacked::BeginTracedPass(wgpu::CommandEncoder& encoder, const char* name) {
+    if (!trace_frame_active_ || trace_query_cursor_ + 2 > kTraceMaxQueries) {
+        return encoder.beginComputePass();
+    }
+    TraceEvent ev;
+    ev.name = name;
+    ev.gpu = true;
+    ev.query_begin = trace_query_cursor_++;
+    ev.query_end = trace_query_cursor_++;
+    trace_pending_.push_back(trace_events_.size());
+    trace_events_.push_back(ev);
+
     wgpu::ComputePassTimestampWrites tsw;
-    tsw.querySet = query_set_;
-    tsw.beginningOfPassWriteIndex = index;
-    tsw.endOfPassWriteIndex = ~0u;
+    tsw.querySet = trace_query_set_;
+    tsw.beginningOfPassWriteIndex = ev.query_begin;
+    tsw.endOfPassWriteIndex = ev.query_end;
     wgpu::ComputePassDescriptor desc;
     desc.timestampWrites = &tsw;
-    wgpu::ComputePassEncoder pass = enc.beginComputePass(desc);
-    pass.end();
+    return encoder.beginComputePass(desc);
+}
+
+void SIFTPacked::AddHostSpan(const char* name, std::chrono::steady_clock::time_point t0,
+                             std::chrono::steady_clock::time_point t1) {
+    TraceEvent ev;
+    ev.name = name;
+    ev.gpu = false;
+    ev.begin_ns = (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(t0.time_since_epoch()).count();
+    ev.end_ns = (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(t1.time_since_epoch()).count();
+    trace_events_.push_back(std::move(ev));
+}
+
+void SIFTPacked::ResolveTraceQueries() {
+    if (trace_query_cursor_ == 0) return;
+    size_t byte_size = (size_t)trace_query_cursor_ * 8;
+    wgpu::CommandEncoder enc = device_.createCommandEncoder();
+    enc.resolveQuerySet(trace_query_set_, 0, trace_query_cursor_, trace_resolve_buf_, 0);
+    enc.copyBufferToBuffer(trace_resolve_buf_, 0, trace_result_buf_, 0, byte_size);
     wgpu::CommandBuffer cmd = enc.finish();
     queue_.submit(1, &cmd);
+
+    bool done = false;
+    wgpu::BufferMapCallbackInfo callbackInfo = {};
+    callbackInfo.mode = wgpu::CallbackMode::AllowSpontaneous;
+    callbackInfo.userdata1 = &done;
+    callbackInfo.callback = [](WGPUMapAsyncStatus, WGPUStringView, void* user1, void*) {
+        *(bool*)user1 = true;
+    };
+    trace_result_buf_.mapAsync(wgpu::MapMode::Read, 0, byte_size, callbackInfo);
+    while (!done) device_.poll(true, nullptr);
+
+    const uint64_t* ticks = (const uint64_t*)trace_result_buf_.getConstMappedRange(0, byte_size);
+    for (size_t idx : trace_pending_) {
+        TraceEvent& ev = trace_events_[idx];
+        ev.begin_ns = (uint64_t)(ticks[ev.query_begin] * (double)timestamp_period_);
+        ev.end_ns = (uint64_t)(ticks[ev.query_end] * (double)timestamp_period_);
+    }
+    trace_result_buf_.unmap();
+    trace_pending_.clear();
+    trace_query_cursor_ = 0;
 }
 
-void SIFTPacked::PrepareDispatch() {
-    // Run a compute shader to calculate workgroup count based on actual keypoint count
-    wgpu::BindGroupEntry entries[2];
-    entries[0].binding = 0; entries[0].buffer = buffers_.keypoints; entries[0].size = 16;
-    entries[1].binding = 1; entries[1].buffer = buffers_.indirect_dispatch; entries[1].size = 24;
-    
-    wgpu::BindGroupDescriptor desc;
-    desc.layout = pipeline_prepare_dispatch_.getBindGroupLayout(0);
-    desc.entryCount = 2;
-    desc.entries = entries;
-    wgpu::BindGroup bind = device_.createBindGroup(desc);
-    
-    wgpu::CommandEncoder enc = device_.createCommandEncoder();
-    wgpu::ComputePassEncoder pass = enc.beginComputePass();
-    pass.setPipeline(pipeline_prepare_dispatch_);
+void SIFTPacked::ExportTrace(const std::string& path) {
+    if (trace_events_.empty()) return;
+
+    // GPU ticks and steady_clock share no epoch; rebase each timeline to its
+    // own earliest event so both start near ts=0 in the viewer.
+    uint64_t gpu_base = ~0ull, host_base = ~0ull;
+    for (const TraceEvent& ev : trace_events_) {
+        uint64_t& base = ev.gpu ? gpu_base : host_base;
+        if (ev.begin_ns < base) base = ev.begin_ns;
+    }
+
+    std::ofstream out(path);
+    if (!out) {
+        std::cerr << "[SIFTPacked] Failed to open trace file: " << path << std::endl;
+        return;
+    }
+    out << "{\"traceEvents\":[\n";
+    out << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":0,\"args\":{\"name\":\"host\"}},\n";
+    out << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":1,\"args\":{\"name\":\"gpu\"}}";
+    char line[256];
+    for (const TraceEvent& ev : trace_events_) {
+        uint64_t base = ev.gpu ? gpu_base : host_base;
+        double ts_us = (ev.begin_ns - base) * 1e-3;
+        double dur_us = ev.end_ns > ev.begin_ns ? (ev.end_ns - ev.begin_ns) * 1e-3 : 0.0;
+        snprintf(line, sizeof(line),
+                 ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":0,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}",
+                 ev.name.c_str(), ev.gpu ? 1 : 0, ts_us, dur_us);
+        out << line;
+    }
+    out << "\n]}\n";
+    trace_events_.clear();
+}
+
+void SIFTPacked::BinKeypoints(wgpu::CommandEncoder& encoder) {
+    // Single-workgroup pass: partitions keypoint indices by octave and writes
+    // per-octave indirect dispatch args, so the orientation/descriptor passes
+    // below visit each keypoint exactly once instead of dispatching the full
+    // list per octave and early-outing on octave mismatch.
+    wgpu::BindGroupEntry entries[3];
+    entries[0].binding = 0; entries[0].buffer = buffers_.keypoints; entries[0].size = buffers_.keypoints.getSize();
+    entries[1].binding = 1; entries[1].buffer = buffers_.octave_bins; entries[1].size = buffers_.octave_bins.getSize();
+    entries[2].binding = 2; entries[2].buffer = buffers_.indirect_dispatch; entries[2].size = buffers_.indirect_dispatch.getSize();
+
+    wgpu::BindGroup bind = AcquirePassBindGroup(pipeline_bin_keypoints_, entries, 3);
+
+    wgpu::ComputePassEncoder pass = BeginTracedPass(encoder, "bin_keypoints");
+    pass.setPipeline(pipeline_bin_keypoints_);
     pass.setBindGroup(0, bind, 0, nullptr);
     pass.dispatchWorkgroups(1, 1, 1);
     pass.end();
-    wgpu::CommandBuffer cmd = enc.finish();
-    queue_.submit(1, &cmd);
 }
 
-void SIFTPacked::RunComputeDescriptors() {
-    wgpu::CommandEncoder encoder = device_.createCommandEncoder();
-    for (int o = 0; o < kNumOctaves; ++o) {
+void SIFTPacked::SelectKeypoints(wgpu::CommandEncoder& encoder) {
+    // Compacts the ~K strongest keypoints (by the contrast response extrema
+    // records in p1) into keypoints_selected, then copies them back over the
+    // keypoint buffer so the binning/orientation/descriptor passes and the
+    // readback all scale with K instead of the raw extrema count.
+    uint32_t k = (uint32_t)options_.maxKeypoints;
+    if (k > (uint32_t)kMaxKeypoints) k = kMaxKeypoints;
+    uint32_t params[] = {k, 0, 0, 0};
+    size_t poff = AcquireUniformSlot(params, sizeof(params));
+
+    wgpu::BindGroupEntry entries[3];
+    entries[0].binding = 0; entries[0].buffer = uniform_arena_; entries[0].offset = poff; entries[0].size = sizeof(params);
+    entries[1].binding = 1; entries[1].buffer = buffers_.keypoints; entries[1].size = buffers_.keypoints.getSize();
+    entries[2].binding = 2; entries[2].buffer = buffers_.keypoints_selected; entries[2].size = buffers_.keypoints_selected.getSize();
+
+    wgpu::BindGroup bind = AcquirePassBindGroup(pipeline_select_keypoints_, entries, 3);
+
+    wgpu::ComputePassEncoder pass = BeginTracedPass(encoder, "select_keypoints");
+    pass.setPipeline(pipeline_select_keypoints_);
+    pass.setBindGroup(0, bind, 0, nullptr);
+    pass.dispatchWorkgroups(1, 1, 1);
+    pass.end();
+
+    encoder.copyBufferToBuffer(buffers_.keypoints_selected, 0, buffers_.keypoints, 0, 16 + (size_t)k * 32);
+}
+
+void SIFTPacked::RunComputeDescriptors(wgpu::CommandEncoder& encoder) {
+    for (int o = 0; o < num_octaves_; ++o) {
         int w = pyramid_cache_->octave_sizes[o].first;
         int h = pyramid_cache_->octave_sizes[o].second;
         uint32_t params[] = {(uint32_t)w, (uint32_t)h, (uint32_t)o, 0};
-        queue_.writeBuffer(buffers_.params16, 0, params, sizeof(params));
-        
-        wgpu::BindGroupEntry entries[6];
-        entries[0].binding = 0; entries[0].buffer = buffers_.params16; entries[0].size = sizeof(params);
+        size_t poff = AcquireUniformSlot(params, sizeof(params));
+
+        wgpu::BindGroupEntry entries[7];
+        entries[0].binding = 0; entries[0].buffer = uniform_arena_; entries[0].offset = poff; entries[0].size = sizeof(params);
         entries[1].binding = 1; entries[1].buffer = buffers_.keypoints; entries[1].size = buffers_.keypoints.getSize();
         entries[2].binding = 2; entries[2].buffer = buffers_.descriptors; entries[2].size = buffers_.descriptors.getSize();
-        entries[3].binding = 3; entries[3].textureView = pyramid_cache_->gaussian_pyramid[o][1].createView();
-        entries[4].binding = 4; entries[4].textureView = pyramid_cache_->gaussian_pyramid[o][2].createView();
-        entries[5].binding = 5; entries[5].textureView = pyramid_cache_->gaussian_pyramid[o][3].createView();
-        
-        wgpu::BindGroupDescriptor bind_desc;
-        bind_desc.layout = pipeline_descriptor_.getBindGroupLayout(0);
-        bind_desc.entryCount = 6;
-        bind_desc.entries = entries;
-        wgpu::BindGroup bind_group = device_.createBindGroup(bind_desc);
-        
-        wgpu::ComputePassEncoder pass = encoder.beginComputePass();
+        entries[3].binding = 3; entries[3].textureView = pyramid_cache_->gaussian_views[o][1];
+        entries[4].binding = 4; entries[4].textureView = pyramid_cache_->gaussian_views[o][2];
+        entries[5].binding = 5; entries[5].textureView = pyramid_cache_->gaussian_views[o][3];
+        entries[6].binding = 6; entries[6].buffer = buffers_.octave_bins; entries[6].size = buffers_.octave_bins.getSize();
+
+        wgpu::BindGroup bind_group = AcquirePassBindGroup(pipeline_descriptor_, entries, 7);
+
+        char label[32];
+        snprintf(label, sizeof(label), "descriptor o%d", o);
+        wgpu::ComputePassEncoder pass = BeginTracedPass(encoder, label);
         pass.setPipeline(pipeline_descriptor_);
         pass.setBindGroup(0, bind_group, 0, nullptr);
-        pass.dispatchWorkgroupsIndirect(buffers_.indirect_dispatch, 12); // Offset 12: descriptor dispatch params
+        pass.dispatchWorkgroupsIndirect(buffers_.indirect_dispatch, (kMaxOctaves + o) * 12); // Descriptor entries follow the orientation entries
         pass.end();
-        wgpu::CommandBuffer commands = encoder.finish();
-        queue_.submit(1, &commands);
-        encoder = device_.createCommandEncoder();
     }
 }
 
@@ -221,12 +475,12 @@ void SIFTPacked::ReadbackDescriptors(std::vector<float>& out_descriptors) {
     }
     size_t desc_elem_size = options_.quantizeDescriptors ? 32 * 4 : 128 * 4;
     size_t size = count * desc_elem_size;
-    wgpu::Buffer read_buf = createBuffer(size, wgpu::BufferUsage::MapRead | wgpu::BufferUsage::CopyDst);
+    wgpu::Buffer read_buf = desc_readback_staging_;
     wgpu::CommandEncoder encoder = device_.createCommandEncoder();
     encoder.copyBufferToBuffer(buffers_.descriptors, 0, read_buf, 0, size);
     wgpu::CommandBuffer cmd = encoder.finish();
     queue_.submit(1, &cmd);
-    
+
     bool done = false;
     wgpu::BufferMapCallbackInfo callbackInfo = {};
     callbackInfo.mode = wgpu::CallbackMode::AllowSpontaneous;
@@ -235,8 +489,11 @@ void SIFTPacked::ReadbackDescriptors(std::vector<float>& out_descriptors) {
         *(bool*)user1 = true;
     };
     read_buf.mapAsync(wgpu::MapMode::Read, 0, size, callbackInfo);
-    while (!done) device_.poll(false, nullptr);
-    
+    // poll(wait=true) blocks in the driver until a submission completes
+    // instead of spinning a core; the loop only guards spurious wakeups.
+    // Same pattern at every mapAsync wait site.
+    while (!done) device_.poll(true, nullptr);
+
     out_descriptors.resize(count * 128);
     if (options_.quantizeDescriptors) {
         const uint8_t* data = (const uint8_t*)read_buf.getConstMappedRange(0, size);
@@ -248,58 +505,366 @@ void SIFTPacked::ReadbackDescriptors(std::vector<float>& out_descriptors) {
     read_buf.unmap();
 }
 
-void SIFTPacked::DetectKeypoints(const uint8_t* image_data, int width, int height) {
-    profiling_ = {}; 
+void SIFTPacked::UploadFrame(const uint8_t* image_data, int width, int height) {
     width_ = width;
     height_ = height;
-    keypoints_.clear();
+    uniform_arena_cursor_ = 0;
 
-    wgpu::TextureDescriptor tdesc;
-    tdesc.size = { (uint32_t)width, (uint32_t)height, 1 };
-    tdesc.sampleCount = 1;
-    tdesc.mipLevelCount = 1;
-    tdesc.format = wgpu::TextureFormat::RGBA8Unorm;
-    tdesc.usage = wgpu::TextureUsage::TextureBinding | wgpu::TextureUsage::CopyDst | wgpu::TextureUsage::RenderAttachment;
-    input_texture_ = device_.createTexture(tdesc);
+    Resize(width, height);
 
+    // grayscaleInput frames are 1 byte per pixel (r8unorm Y plane), 4x less
+    // upload than RGBA8.
+    int bpp = options_.grayscaleInput ? 1 : 4;
     wgpu::TexelCopyTextureInfo dst;
-    dst.texture = input_texture_;
+    dst.texture = pyramid_cache_->input_texture;
     wgpu::TexelCopyBufferLayout layout;
     layout.offset = 0;
-    layout.bytesPerRow = width * 4;
+    layout.bytesPerRow = width * bpp;
     layout.rowsPerImage = height;
     wgpu::Extent3D extent = { (uint32_t)width, (uint32_t)height, 1 };
-    queue_.writeTexture(dst, image_data, width * height * 4, layout, extent);
+    queue_.writeTexture(dst, image_data, (size_t)width * height * bpp, layout, extent);
 
-    Resize(width, height);
+    pyramid_cache_->pass_bind_group_cursor = 0;
     uint32_t zero = 0;
     queue_.writeBuffer(buffers_.keypoints, 0, &zero, 4);
+}
 
-    WriteTimestamp(0);
+void SIFTPacked::EncodeFrame(wgpu::CommandEncoder& encoder, int width, int height, bool with_timestamps,
+                             wgpu::TextureView input_view) {
     int pw = (width + 1) / 2;
     int ph = (height + 1) / 2;
 
-    RunGrayscale(pyramid_cache_->base_texture, pw, ph);
-    WriteTimestamp(1);
-    BuildPyramids(pw, ph);
-    WriteTimestamp(2);
-    DetectExtrema();
-    PrepareDispatch(); // Prepare indirect dispatch buffer based on actual keypoint count
-    WriteTimestamp(3);
-    ComputeOrientations();
-    WriteTimestamp(4);
-    RunComputeDescriptors();
-    WriteTimestamp(5);
-    WriteTimestamp(6);
+    // Record the whole frame into a single command buffer.
+    // Per-pass uniforms go through AcquireUniformSlot so every queue write
+    // lands before the submit instead of forcing a submit per pass.
+    if (with_timestamps) WriteTimestamp(encoder, 0);
+    RunGrayscale(encoder, pw, ph, input_view);
+    if (with_timestamps) WriteTimestamp(encoder, 1);
+    BuildPyramids(encoder, pw, ph);
+    if (with_timestamps) WriteTimestamp(encoder, 2);
+    DetectExtrema(encoder);
+    if (options_.maxKeypoints > 0) SelectKeypoints(encoder); // Top-K by contrast response
+    BinKeypoints(encoder); // Bin keypoints by octave + fill per-octave indirect dispatch args
+    if (with_timestamps) WriteTimestamp(encoder, 3);
+    ComputeOrientations(encoder);
+    if (with_timestamps) WriteTimestamp(encoder, 4);
+    RunComputeDescriptors(encoder);
+    if (with_timestamps) {
+        WriteTimestamp(encoder, 5);
+        WriteTimestamp(encoder, 6);
+    }
+}
+
+void SIFTPacked::ReadbackDescriptorsQuantized(std::vector<uint8_t>& out_descriptors) {
+    size_t count = keypoints_.size();
+    if (count == 0 || !options_.quantizeDescriptors) {
+        out_descriptors.clear();
+        return;
+    }
+    size_t size = count * 128; // 32 u32 words = 128 bytes per descriptor
+    wgpu::Buffer read_buf = desc_readback_staging_;
+    wgpu::CommandEncoder encoder = device_.createCommandEncoder();
+    encoder.copyBufferToBuffer(buffers_.descriptors, 0, read_buf, 0, size);
+    wgpu::CommandBuffer cmd = encoder.finish();
+    queue_.submit(1, &cmd);
+
+    bool done = false;
+    wgpu::BufferMapCallbackInfo callbackInfo = {};
+    callbackInfo.mode = wgpu::CallbackMode::AllowSpontaneous;
+    callbackInfo.userdata1 = &done;
+    callbackInfo.callback = [](WGPUMapAsyncStatus, WGPUStringView, void* user1, void*) {
+        *(bool*)user1 = true;
+    };
+    read_buf.mapAsync(wgpu::MapMode::Read, 0, size, callbackInfo);
+    while (!done) device_.poll(true, nullptr);
+
+    out_descriptors.resize(size);
+    const uint8_t* data = (const uint8_t*)read_buf.getConstMappedRange(0, size);
+    std::memcpy(out_descriptors.data(), data, size);
+    read_buf.unmap();
+}
+
+void SIFTPacked::DetectKeypoints(const uint8_t* image_data, int width, int height) {
+    profiling_ = {};
+    keypoints_.clear();
+    trace_frame_active_ = options_.enableTracing;
+
+    auto t0 = std::chrono::steady_clock::now();
+    UploadFrame(image_data, width, height);
+    auto t1 = std::chrono::steady_clock::now();
+
+    wgpu::CommandEncoder encoder = device_.createCommandEncoder();
+    EncodeFrame(encoder, width, height, /*with_timestamps=*/true);
+    wgpu::CommandBuffer cmd = encoder.finish();
+    // Upload all staged pass parameters in one write; queue writes are
+    // ordered before the submit below.
+    if (uniform_arena_cursor_ > 0) {
+        queue_.writeBuffer(uniform_arena_, 0, uniform_arena_staging_.data(), uniform_arena_cursor_);
+    }
+    queue_.submit(1, &cmd);
+    auto t2 = std::chrono::steady_clock::now();
+
     ReadbackKeypoints();
+    auto t3 = std::chrono::steady_clock::now();
+
+    profiling_.upload_ms = std::chrono::duration<double, std::milli>(t1 - t0).count();
+    profiling_.download_ms = std::chrono::duration<double, std::milli>(t3 - t2).count();
+
+    if (trace_frame_active_) {
+        ResolveTraceQueries();
+        AddHostSpan("upload", t0, t1);
+        AddHostSpan("encode+submit", t1, t2);
+        AddHostSpan("readback", t2, t3);
+        AddHostSpan("frame", t0, t3);
+        trace_frame_active_ = false;
+    }
+}
+
+void SIFTPacked::DetectKeypointsBatch(const std::vector<const uint8_t*>& images,
+                                      int width, int height) {
+    profiling_ = {};
+    keypoints_.clear();
+    batch_keypoints_.clear();
+    batch_descriptors_.clear();
+    if (images.empty()) return;
+
+    // The batch shares the pyramid, uniform arena and keypoint/descriptor
+    // buffers with the async path; drain it before reusing them.
+    WaitIdle();
+
+    width_ = width;
+    height_ = height;
+    Resize(width, height);
+
+    size_t n = images.size();
+
+    // Per-image input textures, pooled at the batch high-water mark so a
+    // steady stream of same-sized wigglegrams allocates nothing per call.
+    if (batch_input_w_ != width || batch_input_h_ != height) {
+        batch_input_textures_.clear();
+        batch_input_views_.clear();
+        batch_input_w_ = width;
+        batch_input_h_ = height;
+    }
+    while (batch_input_textures_.size() < n) {
+        wgpu::TextureDescriptor tdesc;
+        tdesc.size = { (uint32_t)width, (uint32_t)height, 1 };
+        tdesc.sampleCount = 1;
+        tdesc.mipLevelCount = 1;
+        tdesc.format = options_.grayscaleInput ? wgpu::TextureFormat::R8Unorm
+                                               : wgpu::TextureFormat::RGBA8Unorm;
+        tdesc.usage = wgpu::TextureUsage::TextureBinding | wgpu::TextureUsage::CopyDst;
+        batch_input_textures_.push_back(device_.createTexture(tdesc));
+        batch_input_views_.push_back(batch_input_textures_.back().createView());
+    }
+
+    // Upload every frame up front; queue writes are ordered before the
+    // submit, so each frame needs its own texture rather than a rewrite of a
+    // shared one.
+    int bpp = options_.grayscaleInput ? 1 : 4;
+    for (size_t i = 0; i < n; ++i) {
+        wgpu::TexelCopyTextureInfo dst;
+        dst.texture = batch_input_textures_[i];
+        wgpu::TexelCopyBufferLayout layout;
+        layout.offset = 0;
+        layout.bytesPerRow = width * bpp;
+        layout.rowsPerImage = height;
+        wgpu::Extent3D extent = { (uint32_t)width, (uint32_t)height, 1 };
+        queue_.writeTexture(dst, images[i], (size_t)width * height * bpp, layout, extent);
+    }
+
+    size_t desc_elem_size = options_.quantizeDescriptors ? 32 * 4 : 128 * 4;
+    size_t kp_slot_size = 16 + (size_t)kAsyncMaxKeypoints * 32;
+    size_t desc_slot_size = (size_t)kAsyncMaxKeypoints * desc_elem_size;
+    size_t slot_size = kp_slot_size + desc_slot_size;
+    if (batch_staging_size_ < n * slot_size) {
+        batch_staging_ = createBuffer(n * slot_size, wgpu::BufferUsage::MapRead | wgpu::BufferUsage::CopyDst);
+        batch_staging_size_ = n * slot_size;
+    }
+
+    // All frames ride in one command buffer. Each frame's result copies are
+    // recorded before the next frame's passes overwrite the shared keypoint
+    // and descriptor buffers, and the count is zeroed with clearBuffer (a
+    // queue write would land before the whole submit). At a fixed resolution
+    // every frame has identical pass parameters, so each iteration rewrites
+    // the same arena slots and reuses the same cached bind groups.
+    wgpu::CommandEncoder encoder = device_.createCommandEncoder();
+    for (size_t i = 0; i < n; ++i) {
+        uniform_arena_cursor_ = 0;
+        pyramid_cache_->pass_bind_group_cursor = 0;
+        encoder.clearBuffer(buffers_.keypoints, 0, 4);
+        EncodeFrame(encoder, width, height, /*with_timestamps=*/false, batch_input_views_[i]);
+        encoder.copyBufferToBuffer(buffers_.keypoints, 0, batch_staging_, i * slot_size, kp_slot_size);
+        encoder.copyBufferToBuffer(buffers_.descriptors, 0, batch_staging_, i * slot_size + kp_slot_size, desc_slot_size);
+    }
+    wgpu::CommandBuffer cmd = encoder.finish();
+    if (uniform_arena_cursor_ > 0) {
+        queue_.writeBuffer(uniform_arena_, 0, uniform_arena_staging_.data(), uniform_arena_cursor_);
+    }
+    queue_.submit(1, &cmd);
+
+    // One readback for the whole batch.
+    bool done = false;
+    wgpu::BufferMapCallbackInfo callbackInfo = {};
+    callbackInfo.mode = wgpu::CallbackMode::AllowSpontaneous;
+    callbackInfo.userdata1 = &done;
+    callbackInfo.callback = [](WGPUMapAsyncStatus, WGPUStringView, void* user1, void*) {
+        *(bool*)user1 = true;
+    };
+    batch_staging_.mapAsync(wgpu::MapMode::Read, 0, n * slot_size, callbackInfo);
+    while (!done) device_.poll(true, nullptr);
+
+    const uint8_t* raw = (const uint8_t*)batch_staging_.getConstMappedRange(0, n * slot_size);
+    batch_keypoints_.resize(n);
+    batch_descriptors_.resize(n);
+    for (size_t i = 0; i < n; ++i) {
+        const uint8_t* kp_raw = raw + i * slot_size;
+        uint32_t count = *(const uint32_t*)kp_raw;
+        if (count > (uint32_t)kAsyncMaxKeypoints) count = kAsyncMaxKeypoints;
+        const float* kp_data = (const float*)(kp_raw + 16);
+        batch_keypoints_[i].reserve(count);
+        for (uint32_t k = 0; k < count; ++k) {
+            Keypoint kp;
+            kp.x = kp_data[k * 8 + 0]; kp.y = kp_data[k * 8 + 1];
+            kp.octave = kp_data[k * 8 + 2]; kp.scale = kp_data[k * 8 + 3];
+            kp.sigma = kp_data[k * 8 + 4]; kp.orientation = kp_data[k * 8 + 5];
+            batch_keypoints_[i].push_back(kp);
+        }
+
+        batch_descriptors_[i].resize((size_t)count * 128);
+        if (count > 0) {
+            const uint8_t* desc_raw = kp_raw + kp_slot_size;
+            if (options_.quantizeDescriptors) {
+                for (size_t k = 0; k < (size_t)count * 128; ++k) batch_descriptors_[i][k] = (float)desc_raw[k];
+            } else {
+                std::memcpy(batch_descriptors_[i].data(), desc_raw, (size_t)count * desc_elem_size);
+            }
+        }
+    }
+    batch_staging_.unmap();
+
+    // Keep GetKeypoints() coherent with the most recent detection.
+    keypoints_ = batch_keypoints_.back();
+}
+
+SIFTPacked::FrameSlot* SIFTPacked::AcquireFrameSlot() {
+    for (;;) {
+        PollCompletions();
+        for (auto& slot : frame_slots_) {
+            if (!slot.in_flight) return &slot;
+        }
+        device_.poll(true, nullptr);
+    }
+}
+
+void SIFTPacked::SubmitFrame(const uint8_t* image_data, int width, int height,
+                             uint64_t frame_id, FrameCallback callback) {
+    // The pyramid and uniform arena are shared between in-flight frames;
+    // that is safe at a fixed resolution (identical pass parameters, GPU
+    // submissions execute in order), but a resolution change reallocates
+    // them, so drain first.
+    if (pyramid_cache_ && (pyramid_cache_->w != width || pyramid_cache_->h != height)) {
+        WaitIdle();
+    }
+
+    FrameSlot* slot = AcquireFrameSlot();
+    size_t desc_elem_size = options_.quantizeDescriptors ? 32 * 4 : 128 * 4;
+    if (!slot->kp_staging) {
+        slot->kp_staging = createBuffer(16 + (size_t)kAsyncMaxKeypoints * 32, wgpu::BufferUsage::MapRead | wgpu::BufferUsage::CopyDst);
+        slot->desc_staging = createBuffer((size_t)kAsyncMaxKeypoints * desc_elem_size, wgpu::BufferUsage::MapRead | wgpu::BufferUsage::CopyDst);
+    }
+
+    UploadFrame(image_data, width, height);
+
+    wgpu::CommandEncoder encoder = device_.createCommandEncoder();
+    EncodeFrame(encoder, width, height, /*with_timestamps=*/false);
+    // Result copies ride in the same command buffer: the bounded async
+    // staging region is copied unconditionally since the keypoint count is
+    // not known at encode time.
+    encoder.copyBufferToBuffer(buffers_.keypoints, 0, slot->kp_staging, 0, 16 + (size_t)kAsyncMaxKeypoints * 32);
+    encoder.copyBufferToBuffer(buffers_.descriptors, 0, slot->desc_staging, 0, (size_t)kAsyncMaxKeypoints * desc_elem_size);
+    wgpu::CommandBuffer cmd = encoder.finish();
+    if (uniform_arena_cursor_ > 0) {
+        queue_.writeBuffer(uniform_arena_, 0, uniform_arena_staging_.data(), uniform_arena_cursor_);
+    }
+    queue_.submit(1, &cmd);
+
+    slot->in_flight = true;
+    slot->kp_mapped = false;
+    slot->desc_mapped = false;
+    slot->frame_id = frame_id;
+    slot->callback = std::move(callback);
+
+    wgpu::BufferMapCallbackInfo callbackInfo = {};
+    callbackInfo.mode = wgpu::CallbackMode::AllowSpontaneous;
+    callbackInfo.callback = [](WGPUMapAsyncStatus, WGPUStringView, void* user1, void*) {
+        *(bool*)user1 = true;
+    };
+    callbackInfo.userdata1 = &slot->kp_mapped;
+    slot->kp_staging.mapAsync(wgpu::MapMode::Read, 0, 16 + (size_t)kAsyncMaxKeypoints * 32, callbackInfo);
+    callbackInfo.userdata1 = &slot->desc_mapped;
+    slot->desc_staging.mapAsync(wgpu::MapMode::Read, 0, (size_t)kAsyncMaxKeypoints * desc_elem_size, callbackInfo);
+}
+
+void SIFTPacked::PollCompletions() {
+    for (auto& slot : frame_slots_) {
+        if (!slot.in_flight || !slot.kp_mapped || !slot.desc_mapped) continue;
+
+        FrameResult result;
+        result.frame_id = slot.frame_id;
+
+        const uint8_t* kp_raw = (const uint8_t*)slot.kp_staging.getConstMappedRange(0, 16 + (size_t)kAsyncMaxKeypoints * 32);
+        uint32_t count = *(const uint32_t*)kp_raw;
+        if (count > (uint32_t)kAsyncMaxKeypoints) count = kAsyncMaxKeypoints;
+        const float* kp_data = (const float*)(kp_raw + 16);
+        result.keypoints.reserve(count);
+        for (uint32_t i = 0; i < count; ++i) {
+            Keypoint kp;
+            kp.x = kp_data[i * 8 + 0]; kp.y = kp_data[i * 8 + 1];
+            kp.octave = kp_data[i * 8 + 2]; kp.scale = kp_data[i * 8 + 3];
+            kp.sigma = kp_data[i * 8 + 4]; kp.orientation = kp_data[i * 8 + 5];
+            result.keypoints.push_back(kp);
+        }
+
+        size_t desc_elem_size = options_.quantizeDescriptors ? 32 * 4 : 128 * 4;
+        result.descriptors.resize((size_t)count * 128);
+        if (count > 0) {
+            if (options_.quantizeDescriptors) {
+                const uint8_t* data = (const uint8_t*)slot.desc_staging.getConstMappedRange(0, (size_t)kAsyncMaxKeypoints * desc_elem_size);
+                for (size_t i = 0; i < (size_t)count * 128; ++i) result.descriptors[i] = (float)data[i];
+            } else {
+                const float* data = (const float*)slot.desc_staging.getConstMappedRange(0, (size_t)kAsyncMaxKeypoints * desc_elem_size);
+                std::memcpy(result.descriptors.data(), data, (size_t)count * desc_elem_size);
+            }
+        }
+
+        slot.kp_staging.unmap();
+        slot.desc_staging.unmap();
+        slot.in_flight = false;
+        FrameCallback cb = std::move(slot.callback);
+        slot.callback = nullptr;
+        if (cb) cb(std::move(result));
+    }
+}
+
+void SIFTPacked::WaitIdle() {
+    for (;;) {
+        PollCompletions();
+        bool busy = false;
+        for (auto& slot : frame_slots_) busy = busy || slot.in_flight;
+        if (!busy) return;
+        device_.poll(true, nullptr);
+    }
 }
 
 void SIFTPacked::ReadbackKeypoints() {
-    wgpu::Buffer count_buf = createBuffer(4, wgpu::BufferUsage::MapRead | wgpu::BufferUsage::CopyDst);
+    // Count + per-octave bin counts ride in one small readback: count at
+    // offset 0, the binning pass's counts array at offset 16.
+    wgpu::Buffer count_buf = kp_readback_staging_;
     wgpu::CommandEncoder enc = device_.createCommandEncoder();
     enc.copyBufferToBuffer(buffers_.keypoints, 0, count_buf, 0, 4);
-    enc.resolveQuerySet(query_set_, 0, 7, query_resolve_buf_, 0);
-    enc.copyBufferToBuffer(query_resolve_buf_, 0, query_result_buf_, 0, 7 * 8);
+    enc.copyBufferToBuffer(buffers_.octave_bins, 0, count_buf, 16, kMaxOctaves * 4);
+    EncodeStageResolve(enc);
     wgpu::CommandBuffer cmd = enc.finish();
     queue_.submit(1, &cmd);
 
@@ -307,40 +872,50 @@ void SIFTPacked::ReadbackKeypoints() {
     wgpu::BufferMapCallbackInfo callbackInfo = {};
     callbackInfo.mode = wgpu::CallbackMode::AllowSpontaneous;
     callbackInfo.callback = [](WGPUMapAsyncStatus, WGPUStringView, void*, void*) { g_map_done = true; };
-    count_buf.mapAsync(wgpu::MapMode::Read, 0, 4, callbackInfo);
-    while (!g_map_done) device_.poll(false, nullptr);
-    const uint32_t* mapped_count = (const uint32_t*)count_buf.getConstMappedRange(0, 4);
-    uint32_t count = *mapped_count;
+    count_buf.mapAsync(wgpu::MapMode::Read, 0, 16 + kMaxOctaves * 4, callbackInfo);
+    while (!g_map_done) device_.poll(true, nullptr);
+    const uint32_t* mapped_count = (const uint32_t*)count_buf.getConstMappedRange(0, 16 + kMaxOctaves * 4);
+    uint32_t attempted = mapped_count[0];
+    for (int o = 0; o < kMaxOctaves; ++o) profiling_.octave_fill[o] = mapped_count[4 + o];
     count_buf.unmap();
 
-    g_map_done = false;
-    query_result_buf_.mapAsync(wgpu::MapMode::Read, 0, 7 * 8, callbackInfo);
-    while(!g_map_done) device_.poll(false, nullptr);
-    const uint64_t* timestamps = (const uint64_t*)query_result_buf_.getConstMappedRange(0, 7 * 8);
-    double ns_to_ms = 1e-6 * timestamp_period_;
-    profiling_.grayscale_ms = (timestamps[1] - timestamps[0]) * ns_to_ms;
-    profiling_.pyramids_ms = (timestamps[2] - timestamps[1]) * ns_to_ms;
-    profiling_.extrema_ms = (timestamps[3] - timestamps[2]) * ns_to_ms;
-    profiling_.orientation_ms = (timestamps[4] - timestamps[3]) * ns_to_ms;
-    profiling_.descriptor_ms = (timestamps[5] - timestamps[4]) * ns_to_ms;
-    
-    // Total GPU time
-    uint64_t gpu_total_diff = timestamps[6] - timestamps[0];
-    if (timestamps[6] < timestamps[0]) gpu_total_diff = 0; // Handle wraps/errors
-    profiling_.total_ms = gpu_total_diff * ns_to_ms;
-
-    query_result_buf_.unmap();
+    // The extrema shader lets the atomic count run past the buffer capacity
+    // (appends beyond it are discarded), so attempted vs. stored tells us
+    // when a frame silently saturated.
+    uint32_t count = std::min(attempted, (uint32_t)kMaxKeypoints);
+    profiling_.attempted_keypoints = attempted;
+    profiling_.stored_keypoints = count;
+    profiling_.keypoint_overflow = attempted > (uint32_t)kMaxKeypoints;
+    if (profiling_.keypoint_overflow) {
+        std::cerr << "[SIFTPacked] Keypoint buffer saturated: " << attempted
+                  << " extrema for " << kMaxKeypoints << " slots, "
+                  << (attempted - count) << " dropped" << std::endl;
+    }
+
+    // Descriptor dispatch occupancy: each octave dispatches
+    // ceil(fill/64) 64-wide workgroups, so the active-lane fraction is
+    // fill / (64 * workgroups), averaged over the dispatched lanes.
+    uint64_t active_lanes = 0, dispatched_lanes = 0;
+    for (int o = 0; o < num_octaves_; ++o) {
+        uint32_t c = profiling_.octave_fill[o];
+        if (c == 0) continue;
+        active_lanes += c;
+        dispatched_lanes += (uint64_t)((c + 63) / 64) * 64;
+    }
+    profiling_.descriptor_occupancy = dispatched_lanes > 0 ? (double)active_lanes / (double)dispatched_lanes : 0.0;
+
+    ReadStageTimestamps();
 
     if (count == 0) return;
     size_t kp_byte_size = count * 32;
-    wgpu::Buffer read_buf = createBuffer(kp_byte_size, wgpu::BufferUsage::MapRead | wgpu::BufferUsage::CopyDst);
+    wgpu::Buffer read_buf = kp_readback_staging_;
     enc = device_.createCommandEncoder();
     enc.copyBufferToBuffer(buffers_.keypoints, 16, read_buf, 0, kp_byte_size);
     cmd = enc.finish();
     queue_.submit(1, &cmd);
     g_map_done = false;
     read_buf.mapAsync(wgpu::MapMode::Read, 0, kp_byte_size, callbackInfo);
-    while (!g_map_done) device_.poll(false, nullptr);
+    while (!g_map_done) device_.poll(true, nullptr);
     const float* mapped_data = (const float*)read_buf.getConstMappedRange(0, kp_byte_size);
     for (uint32_t i = 0; i < count; ++i) {
         Keypoint kp;
@@ -352,171 +927,158 @@ void SIFTPacked::ReadbackKeypoints() {
     read_buf.unmap();
 }
 
-void SIFTPacked::RunGrayscale(wgpu::Texture output_tex, int pw, int ph) {
+void SIFTPacked::RunGrayscale(wgpu::CommandEncoder& encoder, int pw, int ph, wgpu::TextureView input_view) {
     wgpu::BindGroupEntry entries[2];
-    entries[0].binding = 0; entries[0].textureView = input_texture_.createView();
-    entries[1].binding = 1; entries[1].textureView = output_tex.createView();
-    wgpu::BindGroupDescriptor desc;
-    desc.layout = pipeline_grayscale_.getBindGroupLayout(0);
-    desc.entryCount = 2; desc.entries = entries;
-    wgpu::BindGroup bind = device_.createBindGroup(desc);
-    wgpu::CommandEncoder enc = device_.createCommandEncoder();
-    wgpu::ComputePassEncoder pass = enc.beginComputePass();
+    entries[0].binding = 0; entries[0].textureView = pyramid_cache_->input_view;
+    entries[1].binding = 1; entries[1].textureView = pyramid_cache_->base_view;
+    // Always acquire the canonical cached group first so the positional cache
+    // keeps the same sequence whether or not a batch frame substitutes its
+    // own input texture.
+    wgpu::BindGroup bind = AcquirePassBindGroup(pipeline_grayscale_, entries, 2);
+    if (input_view) {
+        entries[0].textureView = input_view;
+        wgpu::BindGroupDescriptor desc;
+        desc.layout = pipeline_grayscale_.getBindGroupLayout(0);
+        desc.entryCount = 2;
+        desc.entries = entries;
+        bind = device_.createBindGroup(desc);
+    }
+    wgpu::ComputePassEncoder pass = BeginTracedPass(encoder, "grayscale");
     pass.setPipeline(pipeline_grayscale_);
     pass.setBindGroup(0,  bind, 0, nullptr);
     pass.dispatchWorkgroups((pw + 15) / 16,  (ph + 15) / 16, 1);
     pass.end();
-    wgpu::CommandBuffer cmd = enc.finish();
-    queue_.submit(1, &cmd);
 }
 
-void SIFTPacked::BuildPyramids(int pw, int ph) {
+void SIFTPacked::BuildPyramids(wgpu::CommandEncoder& encoder, int pw, int ph) {
     int w = pw; int h = ph;
-    for (int o = 0; o < kNumOctaves; ++o) {
-        auto& gauss_octave = pyramid_cache_->gaussian_pyramid[o];
-        auto& dog_octave = pyramid_cache_->dog_pyramid[o];
-        if (o == 0) RunBlur(pyramid_cache_->base_texture, gauss_octave[0], pyramid_cache_->temp_texture, w, h, kSigmaBase);
+    char label[32];
+    for (int o = 0; o < num_octaves_; ++o) {
+        auto& gauss_views = pyramid_cache_->gaussian_views[o];
+        auto& dog_views = pyramid_cache_->dog_views[o];
+        if (o == 0) RunBlur(encoder, pyramid_cache_->base_view, gauss_views[0], pyramid_cache_->temp_view, w, h, kSigmaBase, "blur o0 s0");
         else {
              int prev_w = pyramid_cache_->octave_sizes[o-1].first;
              int prev_h = pyramid_cache_->octave_sizes[o-1].second;
-             wgpu::Texture prev_tex = pyramid_cache_->gaussian_pyramid[o-1][kScalesPerOctave];
-             RunDownsample(prev_tex, gauss_octave[0], prev_w, prev_h, w, h);
+             wgpu::TextureView prev_view = pyramid_cache_->gaussian_views[o-1][scales_per_octave_];
+             snprintf(label, sizeof(label), "downsample o%d", o);
+             RunDownsample(encoder, prev_view, gauss_views[0], prev_w, prev_h, w, h, label);
         }
-        for (size_t s = 1; s < gauss_octave.size(); ++s) {
+        for (size_t s = 1; s < gauss_views.size(); ++s) {
             float sigma = GetSigma(s);
             float prev_sigma = GetSigma(s - 1);
             float diff = std::sqrt(sigma * sigma - prev_sigma * prev_sigma);
-            RunBlur(gauss_octave[s - 1], gauss_octave[s], pyramid_cache_->temp_texture, w, h, diff);
+            snprintf(label, sizeof(label), "blur o%d s%d", o, (int)s);
+            RunBlur(encoder, gauss_views[s - 1], gauss_views[s], pyramid_cache_->temp_view, w, h, diff, label);
+        }
+        for (size_t s = 0; s < dog_views.size(); ++s) {
+            snprintf(label, sizeof(label), "dog o%d s%d", o, (int)s);
+            RunDoG(encoder, gauss_views[s], gauss_views[s + 1], dog_views[s], w, h, label);
         }
-        for (size_t s = 0; s < dog_octave.size(); ++s) RunDoG(gauss_octave[s], gauss_octave[s + 1], dog_octave[s], w, h);
         w /= 2; h /= 2;
     }
 }
 
 
-void SIFTPacked::RunBlur(wgpu::Texture in_tex, wgpu::Texture out_tex, wgpu::Texture temp_tex, int w, int h, float sigma) {
+void SIFTPacked::RunBlur(wgpu::CommandEncoder& encoder, wgpu::TextureView in_view, wgpu::TextureView out_view, wgpu::TextureView temp_view, int w, int h, float sigma, const char* trace_label) {
     int radius = std::ceil(sigma * 3);
     wgpu::Buffer kernel_buf = GetKernelBuffer(sigma, radius);
     uint32_t params[] = { (uint32_t)w, (uint32_t)h, (uint32_t)radius, 0 };
-    queue_.writeBuffer(buffers_.params16, 0, params, sizeof(params));
-    auto run_pass = [&](wgpu::ComputePipeline pipeline, wgpu::TextureView in_view, wgpu::TextureView out_view) {
+    size_t poff = AcquireUniformSlot(params, sizeof(params));
+    auto run_pass = [&](wgpu::ComputePipeline pipeline, wgpu::TextureView src_view, wgpu::TextureView dst_view, const char* suffix) {
         wgpu::BindGroupEntry entries[4];
-        entries[0].binding = 0; entries[0].buffer = buffers_.params16; entries[0].size = 16;
-        entries[1].binding = 1; entries[1].textureView = in_view;
-        entries[2].binding = 2; entries[2].textureView = out_view;
+        entries[0].binding = 0; entries[0].buffer = uniform_arena_; entries[0].offset = poff; entries[0].size = 16;
+        entries[1].binding = 1; entries[1].textureView = src_view;
+        entries[2].binding = 2; entries[2].textureView = dst_view;
         entries[3].binding = 3; entries[3].buffer = kernel_buf; entries[3].size = WGPU_WHOLE_SIZE;
-        wgpu::BindGroupDescriptor desc;
-        desc.layout = pipeline.getBindGroupLayout(0);
-        desc.entryCount = 4; desc.entries = entries;
-        wgpu::BindGroup bind = device_.createBindGroup(desc);
-        wgpu::CommandEncoder enc = device_.createCommandEncoder();
-        wgpu::ComputePassEncoder pass = enc.beginComputePass();
+        wgpu::BindGroup bind = AcquirePassBindGroup(pipeline, entries, 4);
+        char label[48];
+        snprintf(label, sizeof(label), "%s %s", trace_label, suffix);
+        wgpu::ComputePassEncoder pass = BeginTracedPass(encoder, label);
         pass.setPipeline(pipeline); pass.setBindGroup(0,  bind, 0, nullptr);
         pass.dispatchWorkgroups((w + 15) / 16,  (h + 15) / 16, 1);
         pass.end();
-        wgpu::CommandBuffer cmd = enc.finish();
-        queue_.submit(1, &cmd);
     };
-    run_pass(pipeline_blur_h_, in_tex.createView(), temp_tex.createView());
-    run_pass(pipeline_blur_v_, temp_tex.createView(), out_tex.createView());
+    run_pass(pipeline_blur_h_, in_view, temp_view, "h");
+    run_pass(pipeline_blur_v_, temp_view, out_view, "v");
 }
 
-void SIFTPacked::RunDownsample(wgpu::Texture in_tex, wgpu::Texture out_tex, int sw, int sh, int dw, int dh) {
+void SIFTPacked::RunDownsample(wgpu::CommandEncoder& encoder, wgpu::TextureView in_view, wgpu::TextureView out_view, int sw, int sh, int dw, int dh, const char* trace_label) {
     uint32_t params[] = { (uint32_t)sw, (uint32_t)sh, (uint32_t)dw, (uint32_t)dh };
-    queue_.writeBuffer(buffers_.params16, 0, params, sizeof(params));
+    size_t poff = AcquireUniformSlot(params, sizeof(params));
     wgpu::BindGroupEntry entries[3];
-    entries[0].binding = 0; entries[0].buffer = buffers_.params16; entries[0].size = 16;
-    entries[1].binding = 1; entries[1].textureView = in_tex.createView();
-    entries[2].binding = 2; entries[2].textureView = out_tex.createView();
-    wgpu::BindGroupDescriptor desc;
-    desc.layout = pipeline_downsample_.getBindGroupLayout(0);
-    desc.entryCount = 3; desc.entries = entries;
-    wgpu::BindGroup bind = device_.createBindGroup(desc);
-    wgpu::CommandEncoder enc = device_.createCommandEncoder();
-    wgpu::ComputePassEncoder pass = enc.beginComputePass();
+    entries[0].binding = 0; entries[0].buffer = uniform_arena_; entries[0].offset = poff; entries[0].size = 16;
+    entries[1].binding = 1; entries[1].textureView = in_view;
+    entries[2].binding = 2; entries[2].textureView = out_view;
+    wgpu::BindGroup bind = AcquirePassBindGroup(pipeline_downsample_, entries, 3);
+    wgpu::ComputePassEncoder pass = BeginTracedPass(encoder, trace_label);
     pass.setPipeline(pipeline_downsample_);
     pass.setBindGroup(0,  bind, 0, nullptr);
     pass.dispatchWorkgroups((dw + 15) / 16,  (dh + 15) / 16, 1);
     pass.end();
-    wgpu::CommandBuffer cmd = enc.finish();
-    queue_.submit(1, &cmd);
 }
 
-void SIFTPacked::RunDoG(wgpu::Texture tex_a, wgpu::Texture tex_b, wgpu::Texture out_tex, int w, int h) {
+void SIFTPacked::RunDoG(wgpu::CommandEncoder& encoder, wgpu::TextureView view_a, wgpu::TextureView view_b, wgpu::TextureView out_view, int w, int h, const char* trace_label) {
     wgpu::BindGroupEntry entries[3];
-    entries[0].binding = 0; entries[0].textureView = tex_a.createView();
-    entries[1].binding = 1; entries[1].textureView = tex_b.createView();
-    entries[2].binding = 2; entries[2].textureView = out_tex.createView();
-    wgpu::BindGroupDescriptor desc;
-    desc.layout = pipeline_dog_.getBindGroupLayout(0);
-    desc.entryCount = 3; desc.entries = entries;
-    wgpu::BindGroup bind = device_.createBindGroup(desc);
-    wgpu::CommandEncoder enc = device_.createCommandEncoder();
-    wgpu::ComputePassEncoder pass = enc.beginComputePass();
+    entries[0].binding = 0; entries[0].textureView = view_a;
+    entries[1].binding = 1; entries[1].textureView = view_b;
+    entries[2].binding = 2; entries[2].textureView = out_view;
+    wgpu::BindGroup bind = AcquirePassBindGroup(pipeline_dog_, entries, 3);
+    wgpu::ComputePassEncoder pass = BeginTracedPass(encoder, trace_label);
     pass.setPipeline(pipeline_dog_);
     pass.setBindGroup(0,  bind, 0, nullptr);
     pass.dispatchWorkgroups((w + 15) / 16,  (h + 15) / 16, 1);
     pass.end();
-    wgpu::CommandBuffer cmd = enc.finish();
-    queue_.submit(1, &cmd);
 }
 
-void SIFTPacked::DetectExtrema() {
-    for (int o = 0; o < kNumOctaves; ++o) {
+void SIFTPacked::DetectExtrema(wgpu::CommandEncoder& encoder) {
+    for (int o = 0; o < num_octaves_; ++o) {
         int w = pyramid_cache_->octave_sizes[o].first;
         int h = pyramid_cache_->octave_sizes[o].second;
-        for (int s = 1; s <= kScalesPerOctave; ++s) {
+        for (int s = 1; s <= scales_per_octave_; ++s) {
             struct { int w, h, o, s; float contrast, edge; } p;
             p.w = w; p.h = h; p.o = o; p.s = s;
-            p.contrast = (options_.contrastThreshold / kScalesPerOctave);
+            p.contrast = (options_.contrastThreshold / scales_per_octave_);
             p.edge = options_.edgeThreshold;
-            queue_.writeBuffer(buffers_.params_extrema, 0, &p, sizeof(p));
+            size_t poff = AcquireUniformSlot(&p, sizeof(p));
             wgpu::BindGroupEntry entries[5];
-            entries[0].binding = 0; entries[0].buffer = buffers_.params_extrema; entries[0].size = 24;
-            entries[1].binding = 1; entries[1].textureView = pyramid_cache_->dog_pyramid[o][s - 1].createView();
-            entries[2].binding = 2; entries[2].textureView = pyramid_cache_->dog_pyramid[o][s].createView();
-            entries[3].binding = 3; entries[3].textureView = pyramid_cache_->dog_pyramid[o][s + 1].createView();
+            entries[0].binding = 0; entries[0].buffer = uniform_arena_; entries[0].offset = poff; entries[0].size = 24;
+            entries[1].binding = 1; entries[1].textureView = pyramid_cache_->dog_views[o][s - 1];
+            entries[2].binding = 2; entries[2].textureView = pyramid_cache_->dog_views[o][s];
+            entries[3].binding = 3; entries[3].textureView = pyramid_cache_->dog_views[o][s + 1];
             entries[4].binding = 4; entries[4].buffer = buffers_.keypoints; entries[4].size = 16 + kMaxKeypoints * 32;
-            wgpu::BindGroupDescriptor desc;
-            desc.layout = pipeline_extrema_.getBindGroupLayout(0);
-            desc.entryCount = 5; desc.entries = entries;
-            wgpu::BindGroup bind = device_.createBindGroup(desc);
-            wgpu::CommandEncoder enc = device_.createCommandEncoder();
-            wgpu::ComputePassEncoder pass = enc.beginComputePass();
+            wgpu::BindGroup bind = AcquirePassBindGroup(pipeline_extrema_, entries, 5);
+            char label[32];
+            snprintf(label, sizeof(label), "extrema o%d s%d", o, s);
+            wgpu::ComputePassEncoder pass = BeginTracedPass(encoder, label);
             pass.setPipeline(pipeline_extrema_);
             pass.setBindGroup(0,  bind, 0, nullptr);
             pass.dispatchWorkgroups((w + 15) / 16,  (h + 15) / 16, 1);
             pass.end();
-            wgpu::CommandBuffer cmd = enc.finish();
-            queue_.submit(1, &cmd);
         }
     }
 }
 
-void SIFTPacked::ComputeOrientations() {
-    for (int o = 0; o < kNumOctaves; ++o) {
+void SIFTPacked::ComputeOrientations(wgpu::CommandEncoder& encoder) {
+    for (int o = 0; o < num_octaves_; ++o) {
         int w = pyramid_cache_->octave_sizes[o].first;
         int h = pyramid_cache_->octave_sizes[o].second;
         struct { int w, h, o; } p = { w, h, o };
-        wgpu::Buffer pbuf = createBuffer(12, wgpu::BufferUsage::Uniform | wgpu::BufferUsage::CopyDst);
-        queue_.writeBuffer(pbuf, 0, &p, sizeof(p));
-        wgpu::BindGroupEntry entries[5];
-        entries[0].binding = 0; entries[0].buffer = pbuf; entries[0].size = 12;
+        size_t poff = AcquireUniformSlot(&p, sizeof(p));
+        wgpu::BindGroupEntry entries[6];
+        entries[0].binding = 0; entries[0].buffer = uniform_arena_; entries[0].offset = poff; entries[0].size = 12;
         entries[1].binding = 1; entries[1].buffer = buffers_.keypoints; entries[1].size = 16 + kMaxKeypoints * 32;
-        entries[2].binding = 2; entries[2].textureView = pyramid_cache_->gaussian_pyramid[o][1].createView();
-        entries[3].binding = 3; entries[3].textureView = pyramid_cache_->gaussian_pyramid[o][2].createView();
-        entries[4].binding = 4; entries[4].textureView = pyramid_cache_->gaussian_pyramid[o][3].createView();
-        wgpu::BindGroupDescriptor desc;
-        desc.layout = pipeline_orientation_.getBindGroupLayout(0);
-        desc.entryCount = 5; desc.entries = entries;
-        wgpu::BindGroup bind = device_.createBindGroup(desc);
-        wgpu::CommandEncoder enc = device_.createCommandEncoder();
-        wgpu::ComputePassEncoder pass = enc.beginComputePass();
+        entries[2].binding = 2; entries[2].textureView = pyramid_cache_->gaussian_views[o][1];
+        entries[3].binding = 3; entries[3].textureView = pyramid_cache_->gaussian_views[o][2];
+        entries[4].binding = 4; entries[4].textureView = pyramid_cache_->gaussian_views[o][3];
+        entries[5].binding = 5; entries[5].buffer = buffers_.octave_bins; entries[5].size = buffers_.octave_bins.getSize();
+        wgpu::BindGroup bind = AcquirePassBindGroup(pipeline_orientation_, entries, 6);
+        char label[32];
+        snprintf(label, sizeof(label), "orientation o%d", o);
+        wgpu::ComputePassEncoder pass = BeginTracedPass(encoder, label);
         pass.setPipeline(pipeline_orientation_);
         pass.setBindGroup(0,  bind, 0, nullptr);
-        pass.dispatchWorkgroupsIndirect(buffers_.indirect_dispatch, 0); // Offset 0: orientation dispatch params
+        pass.dispatchWorkgroupsIndirect(buffers_.indirect_dispatch, o * 12); // One orientation entry per octave
         pass.end();
-        wgpu::CommandBuffer cmd = enc.finish();
-        queue_.submit(1, &cmd);
     }
 }
@@ -5,17 +5,6 @@
 
 #include <chrono>
 
-struct SIFTProfiling {
-    double total_ms = 0;
-    double upload_ms = 0;
-    double grayscale_ms = 0;
-    double pyramids_ms = 0;
-    double extrema_ms = 0;
-    double orientation_ms = 0;
-    double descriptor_ms = 0;
-    double download_ms = 0;
-};
-
 class SIFTPacked : public SIFTBase {
  public:
     SIFTPacked();
@@ -24,43 +13,145 @@ class SIFTPacked : public SIFTBase {
     void Init(wgpu::Device device, const SIFTOptions& options = SIFTOptions()) override;
     void Resize(int width, int height) override;
     void DetectKeypoints(const uint8_t* image_data, int width, int height) override;
-    void ReadbackDescriptors(std::vector<float>& out_descriptors); // Moved to public
+    // Batched path: all frames are encoded into one command buffer (each with
+    // its own input texture), per-frame results are copied into a shared
+    // staging buffer between frames, and one submit + one map covers the
+    // whole batch. Frames with more than kAsyncMaxKeypoints keypoints are
+    // truncated, same as the async path.
+    void DetectKeypointsBatch(const std::vector<const uint8_t*>& images,
+                              int width, int height) override;
+    void ReadbackDescriptors(std::vector<float>& out_descriptors) override;
+    // Quantized readback without the u8->f32 expansion: 128 raw bytes per
+    // keypoint, exactly as written by descriptor_quantized.wgsl. Only valid
+    // when options.quantizeDescriptors is set.
+    void ReadbackDescriptorsQuantized(std::vector<uint8_t>& out_descriptors);
+
+    // Async path: up to two frames in flight, each with its own staging
+    // buffers so frame N+1 uploads and encodes while frame N maps back.
+    void SubmitFrame(const uint8_t* image_data, int width, int height,
+                     uint64_t frame_id, FrameCallback callback) override;
+    void WaitIdle() override;
 
-    const SIFTProfiling& GetProfiling() const { return profiling_; }
+    // Writes every span captured since the last export (GPU passes and host
+    // upload/encode/readback spans, see SIFTOptions::enableTracing) as
+    // chrome://tracing JSON and clears the capture window. Load the file at
+    // chrome://tracing or ui.perfetto.dev. No-op unless tracing is enabled.
+    void ExportTrace(const std::string& path);
+
+    // GPU-resident descriptor buffer for direct matcher interop (see the
+    // wgpu::Buffer overloads on SIFTMatcher); valid entries = GetKeypointsCount().
+    // Layout: 128 f32 per keypoint, or 32 u32 when quantizeDescriptors is set.
+    wgpu::Buffer GetDescriptorBuffer() const { return buffers_.descriptors; }
 
  private:
-    SIFTProfiling profiling_;
     void InitPipelines();
     void InitBuffers();
-    
+
     std::string loadShader(const std::string& filename);
-    
-    // Dispatchers
-    void RunGrayscale(wgpu::Texture output_tex, int pw, int ph);
-    void BuildPyramids(int pw, int ph);
-    void RunBlur(wgpu::Texture in_tex, wgpu::Texture out_tex, wgpu::Texture temp_tex, int w, int h, float sigma);
-    void RunDownsample(wgpu::Texture in_tex, wgpu::Texture out_tex, int sw, int sh, int dw, int dh);
-    void RunDoG(wgpu::Texture tex_a, wgpu::Texture tex_b, wgpu::Texture out_tex, int w, int h);
-    void DetectExtrema();
-    void ComputeOrientations();
-    void PrepareDispatch(); // Prepares indirect dispatch buffer
-    void RunComputeDescriptors();
+
+    // Per-frame uniform arena: every pass stages its parameters into one
+    // large uniform buffer (256-byte aligned slots) and binds its slot via a
+    // buffer offset. The whole arena is uploaded with a single writeBuffer
+    // per DetectKeypoints call instead of ~40 tiny queue writes.
+    // Returns the byte offset of the slot inside uniform_arena_.
+    size_t AcquireUniformSlot(const void* data, size_t size);
+
+    // Encoders: record into the shared per-frame command encoder, no submits.
+    // input_view (batch path only) substitutes a per-image input texture for
+    // the cache's own; null uses pyramid_cache_->input_view.
+    void RunGrayscale(wgpu::CommandEncoder& encoder, int pw, int ph,
+                      wgpu::TextureView input_view = nullptr);
+    void BuildPyramids(wgpu::CommandEncoder& encoder, int pw, int ph);
+    void RunBlur(wgpu::CommandEncoder& encoder, wgpu::TextureView in_view, wgpu::TextureView out_view, wgpu::TextureView temp_view, int w, int h, float sigma, const char* trace_label);
+    void RunDownsample(wgpu::CommandEncoder& encoder, wgpu::TextureView in_view, wgpu::TextureView out_view, int sw, int sh, int dw, int dh, const char* trace_label);
+    void RunDoG(wgpu::CommandEncoder& encoder, wgpu::TextureView view_a, wgpu::TextureView view_b, wgpu::TextureView out_view, int w, int h, const char* trace_label);
+    void DetectExtrema(wgpu::CommandEncoder& encoder);
+    void ComputeOrientations(wgpu::CommandEncoder& encoder);
+    void BinKeypoints(wgpu::CommandEncoder& encoder); // Bins keypoints by octave + prepares per-octave indirect dispatch args
+    void SelectKeypoints(wgpu::CommandEncoder& encoder); // Top-K selection by contrast response (options_.maxKeypoints)
+    void RunComputeDescriptors(wgpu::CommandEncoder& encoder);
     void ReadbackKeypoints();
 
-    void WriteTimestamp(uint32_t index);
+    // Per-pass tracing (options_.enableTracing). Every compute pass opens
+    // through BeginTracedPass, which attaches beginning/end-of-pass timestamp
+    // writes and records a pending span; ResolveTraceQueries converts the
+    // raw ticks after the frame's readback. Host spans are recorded with
+    // std::chrono on the same event list. Only the synchronous
+    // DetectKeypoints path captures; the async and batch paths encode plain
+    // passes so their pipelining is unaffected.
+    struct TraceEvent {
+        std::string name;
+        bool gpu = false;
+        uint32_t query_begin = 0;  // GPU spans: indices into trace_query_set_
+        uint32_t query_end = 0;
+        uint64_t begin_ns = 0;     // Resolved at readback (GPU) or recorded (host)
+        uint64_t end_ns = 0;
+    };
+    wgpu::ComputePassEncoder BeginTracedPass(wgpu::CommandEncoder& encoder, const char* name);
+    void AddHostSpan(const char* name, std::chrono::steady_clock::time_point t0,
+                     std::chrono::steady_clock::time_point t1);
+    void ResolveTraceQueries();
+
+    // Shared by the sync and async paths
+    void UploadFrame(const uint8_t* image_data, int width, int height);
+    void EncodeFrame(wgpu::CommandEncoder& encoder, int width, int height, bool with_timestamps,
+                     wgpu::TextureView input_view = nullptr);
+
+    // Frames in flight (SubmitFrame/WaitIdle)
+    struct FrameSlot {
+        bool in_flight = false;
+        bool kp_mapped = false;
+        bool desc_mapped = false;
+        uint64_t frame_id = 0;
+        FrameCallback callback;
+        wgpu::Buffer kp_staging;   // 16-byte header + kAsyncMaxKeypoints points
+        wgpu::Buffer desc_staging; // kAsyncMaxKeypoints descriptors
+    };
+    FrameSlot frame_slots_[2];
+    FrameSlot* AcquireFrameSlot();
+    void PollCompletions();
 
 
     // Data
     struct PyramidCache {
         int w, h;
+        // Input texture lives with the pyramid: same lifetime, same
+        // resolution key, and keeping it lets the grayscale bind group be
+        // cached like every other pass.
+        wgpu::Texture input_texture;
+        wgpu::TextureView input_view;
         wgpu::Texture base_texture;
         wgpu::Texture temp_texture;
         std::vector<std::vector<wgpu::Texture>> gaussian_pyramid;
         std::vector<std::vector<wgpu::Texture>> dog_pyramid;
         std::vector<std::pair<int, int>> octave_sizes;
+
+        // Views are created once in Resize; calling createView() per pass per
+        // frame allocated thousands of wgpu objects per second at video rate.
+        wgpu::TextureView base_view;
+        wgpu::TextureView temp_view;
+        std::vector<std::vector<wgpu::TextureView>> gaussian_views;
+        std::vector<std::vector<wgpu::TextureView>> dog_views;
+
+        // Per-pass bind groups, cached in encode order. The pass sequence and
+        // every bound resource (pyramid views, uniform arena offsets, keypoint
+        // buffers) are fixed for a given resolution, so groups created on the
+        // first frame are valid for every following frame.
+        std::vector<wgpu::BindGroup> pass_bind_groups;
+        size_t pass_bind_group_cursor = 0;
     };
     std::unique_ptr<PyramidCache> pyramid_cache_;
 
+    // Recently used pyramids, most recent at the back. Ingest alternating
+    // between a few fixed camera resolutions swaps caches instead of
+    // reallocating dozens of RGBA32Float textures on every switch.
+    std::vector<std::unique_ptr<PyramidCache>> pyramid_pool_;
+
+    // Returns the cached bind group for the current pass slot, creating it on
+    // the first frame after a Resize. Must be called in the same order every
+    // frame (guaranteed by the fixed pass sequence in DetectKeypoints).
+    wgpu::BindGroup AcquirePassBindGroup(wgpu::ComputePipeline& pipeline, const wgpu::BindGroupEntry* entries, size_t count);
+
     // Pipelines
     wgpu::ComputePipeline pipeline_grayscale_;
     wgpu::ComputePipeline pipeline_blur_h_;
@@ -70,31 +161,74 @@ class SIFTPacked : public SIFTBase {
     wgpu::ComputePipeline pipeline_extrema_;
     wgpu::ComputePipeline pipeline_orientation_;
     wgpu::ComputePipeline pipeline_descriptor_;
-    wgpu::ComputePipeline pipeline_prepare_dispatch_;
+    wgpu::ComputePipeline pipeline_bin_keypoints_;
+    wgpu::ComputePipeline pipeline_select_keypoints_;
 
     struct Buffers {
         wgpu::Buffer keypoints;
         wgpu::Buffer descriptors;
-        wgpu::Buffer params16;
-        wgpu::Buffer params_extrema;
-        wgpu::Buffer indirect_dispatch; // For dispatchWorkgroupsIndirect
+        wgpu::Buffer indirect_dispatch;   // Per-octave args for dispatchWorkgroupsIndirect
+        wgpu::Buffer octave_bins;         // Keypoint indices partitioned by octave (bin_keypoints.wgsl)
+        wgpu::Buffer keypoints_selected;  // Top-K compaction target (only when options.maxKeypoints > 0)
     } buffers_;
 
-    wgpu::Texture input_texture_;
-    
-    // Timestamp Query
-    wgpu::QuerySet query_set_;
-    wgpu::Buffer query_resolve_buf_;
-    wgpu::Buffer query_result_buf_;
-    float timestamp_period_ = 1.0f;
+    // Batch detection: per-image input textures (pooled at the batch
+    // high-water mark) and one staging buffer covering every frame's
+    // keypoint + descriptor slots, mapped once per batch.
+    std::vector<wgpu::Texture> batch_input_textures_;
+    std::vector<wgpu::TextureView> batch_input_views_;
+    int batch_input_w_ = 0;
+    int batch_input_h_ = 0;
+    wgpu::Buffer batch_staging_;
+    size_t batch_staging_size_ = 0;
+
+    // Per-frame uniform arena (see AcquireUniformSlot)
+    wgpu::Buffer uniform_arena_;
+    std::vector<uint8_t> uniform_arena_staging_;
+    size_t uniform_arena_cursor_ = 0;
+
+    // Persistent readback staging, sized for kMaxKeypoints worst case so the
+    // synchronous readback path performs zero buffer allocations per frame.
+    wgpu::Buffer kp_readback_staging_;
+    wgpu::Buffer desc_readback_staging_;
+
+    // Tracing state (allocated only when options_.enableTracing)
+    std::vector<TraceEvent> trace_events_;
+    std::vector<size_t> trace_pending_;   // Events awaiting query resolution
+    uint32_t trace_query_cursor_ = 0;
+    bool trace_frame_active_ = false;
+    wgpu::QuerySet trace_query_set_;
+    wgpu::Buffer trace_resolve_buf_;
+    wgpu::Buffer trace_result_buf_;
+
+    // Pyramid shape, from SIFTOptions (see Init); octaves clamped to
+    // [1, kMaxOctaves] to match the GPU-side bin/dispatch buffer layout.
+    int num_octaves_ = 4;
+    int scales_per_octave_ = 3;
 
     // Constants
-    static constexpr int kNumOctaves = 4;
-    static constexpr int kScalesPerOctave = 3;
+    static constexpr int kMaxOctaves = 8; // MAX_OCTAVES in bin_keypoints.wgsl
+    // Parked pyramids besides the active one; 1080p RGBA32Float pyramids are
+    // ~50 MB each, so cap how many resolutions stay warm.
+    static constexpr size_t kPyramidPoolCap = 3;
     static constexpr float kSigmaBase = 1.6f;
     static constexpr float kContrastThreshold = 0.03f;
     static constexpr float kEdgeThreshold = 10.0f;
     static constexpr int kMaxKeypoints = 100000;
+    // Async staging is bounded so two frames in flight don't cost 2x the
+    // worst-case descriptor buffer (~51 MB); frames with more keypoints than
+    // this are truncated on the async path only.
+    static constexpr int kAsyncMaxKeypoints = 16384;
+    // Trace query budget: two timestamps per pass. A frame runs roughly
+    // 2*octaves*(scales+3) blur sub-passes plus the per-octave/per-scale DoG,
+    // extrema, orientation and descriptor passes — under 200 passes even at
+    // kMaxOctaves, so 512 queries leaves headroom. Passes past the budget
+    // encode untraced.
+    static constexpr uint32_t kTraceMaxQueries = 512;
+    // WebGPU minUniformBufferOffsetAlignment: offsets into the arena must be
+    // 256-byte aligned, so each pass slot takes one aligned stride.
+    static constexpr size_t kUniformSlotStride = 256;
+    static constexpr size_t kUniformArenaSize = 64 * 1024; // 256 slots, plenty for one frame
 };
 
 #endif  // WEBSIFTGPU_CPP_SRC_SIFT_PACKED_H_
@@ -0,0 +1,169 @@
+#include "sift_scheduler.h"
+
+#include <iostream>
+
+// wgpu-native extension (wgpu.h): enumerate every adapter up front instead
+// of taking whichever one requestAdapter happens to return. Declared here
+// like wgpuQueueGetTimestampPeriod in sift_packed.cpp rather than pulling in
+// all of wgpu.h.
+extern "C" {
+typedef struct WGPUInstanceEnumerateAdapterOptions WGPUInstanceEnumerateAdapterOptions;
+size_t wgpuInstanceEnumerateAdapters(WGPUInstance instance,
+                                     const WGPUInstanceEnumerateAdapterOptions* options,
+                                     WGPUAdapter* adapters);
+}
+
+SIFTScheduler::SIFTScheduler() = default;
+
+SIFTScheduler::~SIFTScheduler() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    work_cv_.notify_all();
+    for (auto& ctx : devices_) {
+        if (ctx->worker.joinable()) ctx->worker.join();
+    }
+}
+
+int SIFTScheduler::Init(const SIFTOptions& options) {
+    instance_ = wgpu::createInstance();
+    if (!instance_) {
+        std::cerr << "[SIFTScheduler] Failed to create WebGPU instance." << std::endl;
+        return 0;
+    }
+
+    // Null options = all backends.
+    size_t adapter_count = wgpuInstanceEnumerateAdapters(instance_, nullptr, nullptr);
+    std::vector<WGPUAdapter> raw_adapters(adapter_count);
+    wgpuInstanceEnumerateAdapters(instance_, nullptr, raw_adapters.data());
+
+    for (size_t i = 0; i < adapter_count; ++i) {
+        wgpu::Adapter adapter = raw_adapters[i];
+
+        wgpu::AdapterInfo info = {};
+        adapter.getInfo(&info);
+        // Software rasterizers would serialize behind the real GPUs; skip
+        // them when at least one hardware adapter exists.
+        if (info.adapterType == wgpu::AdapterType::CPU && !devices_.empty()) continue;
+
+        wgpu::DeviceDescriptor deviceDesc = {};
+        deviceDesc.label = wgpu::StringView("WebSIFTGPU Scheduler Device");
+        std::vector<wgpu::FeatureName> requiredFeatures;
+        requiredFeatures.push_back(wgpu::FeatureName::TimestampQuery);
+        deviceDesc.requiredFeatures = (const WGPUFeatureName*)requiredFeatures.data();
+        deviceDesc.requiredFeatureCount = requiredFeatures.size();
+        deviceDesc.uncapturedErrorCallbackInfo.callback =
+            [](const WGPUDevice*, WGPUErrorType type, WGPUStringView message, void*, void*) {
+                std::cerr << "[SIFTScheduler] Uncaptured WebGPU Error (" << type << "): ";
+                if (message.data) std::cerr << std::string(message.data, message.length);
+                std::cerr << std::endl;
+            };
+
+        wgpu::Device device = adapter.requestDevice(deviceDesc);
+        if (!device) {
+            std::cerr << "[SIFTScheduler] Device request failed for adapter " << i << ", skipping." << std::endl;
+            continue;
+        }
+
+        auto ctx = std::make_unique<DeviceContext>();
+        ctx->index = (int)devices_.size();
+        ctx->device = device;
+        ctx->sift = std::make_unique<SIFTPacked>();
+        ctx->sift->Init(device, options);
+        ctx->matcher = std::make_unique<SIFTMatcher>();
+        ctx->matcher->Init(device);
+        std::cout << "[SIFTScheduler] Device " << ctx->index << ": "
+                  << (info.device.data ? std::string(info.device.data, info.device.length) : "Unknown") << std::endl;
+        devices_.push_back(std::move(ctx));
+    }
+
+    for (auto& ctx : devices_) {
+        DeviceContext* raw = ctx.get();
+        ctx->worker = std::thread([this, raw] { WorkerLoop(raw); });
+    }
+    return (int)devices_.size();
+}
+
+void SIFTScheduler::EnqueueImage(uint64_t image_id, const uint8_t* image_data, int width, int height) {
+    WorkItem item;
+    item.image_id = image_id;
+    item.pixels.assign(image_data, image_data + (size_t)width * height * 4);
+    item.width = width;
+    item.height = height;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        // Round-robin placement; stealing evens out whatever imbalance the
+        // frame contents cause.
+        devices_[enqueue_cursor_ % devices_.size()]->queue.push_back(std::move(item));
+        ++enqueue_cursor_;
+    }
+    work_cv_.notify_all();
+}
+
+bool SIFTScheduler::TakeWork(DeviceContext* ctx, WorkItem& item) {
+    if (!ctx->queue.empty()) {
+        item = std::move(ctx->queue.front());
+        ctx->queue.pop_front();
+        return true;
+    }
+    DeviceContext* victim = nullptr;
+    for (auto& other : devices_) {
+        if (other.get() == ctx || other->queue.empty()) continue;
+        if (!victim || other->queue.size() > victim->queue.size()) victim = other.get();
+    }
+    if (!victim) return false;
+    item = std::move(victim->queue.back());
+    victim->queue.pop_back();
+    return true;
+}
+
+void SIFTScheduler::WorkerLoop(DeviceContext* ctx) {
+    for (;;) {
+        WorkItem item;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            while (!stop_ && !TakeWork(ctx, item)) {
+                drain_cv_.notify_all();
+                work_cv_.wait(lock);
+            }
+            if (stop_) return;
+            ++busy_workers_;
+        }
+
+        SchedulerResult result;
+        result.image_id = item.image_id;
+        result.device_index = ctx->index;
+        ctx->sift->DetectKeypoints(item.pixels.data(), item.width, item.height);
+        result.keypoints = ctx->sift->GetKeypoints();
+        ctx->sift->ReadbackDescriptors(result.descriptors);
+
+        {
+            std::lock_guard<std::mutex> lock(results_mutex_);
+            results_.push_back(std::move(result));
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            --busy_workers_;
+        }
+        drain_cv_.notify_all();
+    }
+}
+
+std::vector<SchedulerResult> SIFTScheduler::DrainResults() {
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        drain_cv_.wait(lock, [this] {
+            if (busy_workers_ > 0) return false;
+            for (auto& ctx : devices_) {
+                if (!ctx->queue.empty()) return false;
+            }
+            return true;
+        });
+    }
+    std::lock_guard<std::mutex> lock(results_mutex_);
+    std::vector<SchedulerResult> out;
+    out.swap(results_);
+    return out;
+}
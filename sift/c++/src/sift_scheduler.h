@@ -0,0 +1,90 @@
+#ifndef WEBSIFTGPU_CPP_SRC_SIFT_SCHEDULER_H_
+#define WEBSIFTGPU_CPP_SRC_SIFT_SCHEDULER_H_
+
+#include "sift_base.h"
+#include "sift_matcher.h"
+#include "sift_packed.h"
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+// One detection result from the scheduler; device_index says which GPU
+// produced it (useful for routing follow-up GPU-resident matching to the
+// matcher living on the same device).
+struct SchedulerResult {
+    uint64_t image_id = 0;
+    int device_index = 0;
+    std::vector<Keypoint> keypoints;
+    std::vector<float> descriptors;
+};
+
+// Multi-GPU scheduler: enumerates every adapter on the machine, owns one
+// initialized SIFTPacked + SIFTMatcher per device, and feeds them from
+// per-device work queues with stealing. Frames are embarrassingly parallel
+// across devices, so a 2-GPU ingest server gets close to 2x the throughput
+// of the single-device path in main.cpp.
+class SIFTScheduler {
+ public:
+    SIFTScheduler();
+    ~SIFTScheduler();
+
+    // Enumerates adapters and spins one worker thread per created device.
+    // Returns the number of usable devices; 0 means no adapter worked.
+    int Init(const SIFTOptions& options = SIFTOptions());
+
+    // Copies the image and queues it for detection on whichever device gets
+    // to it first. Returns immediately.
+    void EnqueueImage(uint64_t image_id, const uint8_t* image_data, int width, int height);
+
+    // Blocks until every enqueued image has been processed and returns all
+    // accumulated results. Completion order is whatever the devices produced;
+    // callers needing frame order should sort by image_id.
+    std::vector<SchedulerResult> DrainResults();
+
+    int NumDevices() const { return (int)devices_.size(); }
+
+    // The matcher bound to one device, for matching descriptors produced on
+    // that same device (GPU-resident buffers cannot cross devices).
+    SIFTMatcher* GetMatcher(int device_index) { return devices_[device_index]->matcher.get(); }
+
+ private:
+    struct WorkItem {
+        uint64_t image_id;
+        std::vector<uint8_t> pixels;
+        int width;
+        int height;
+    };
+
+    struct DeviceContext {
+        int index = 0;
+        wgpu::Device device;
+        std::unique_ptr<SIFTPacked> sift;
+        std::unique_ptr<SIFTMatcher> matcher;
+        std::thread worker;
+        // Owner pops from the front; thieves steal from the back, so the
+        // owner keeps whatever locality the enqueue order had.
+        std::deque<WorkItem> queue;
+    };
+
+    void WorkerLoop(DeviceContext* ctx);
+    // Caller must hold mutex_. Pops the next item for ctx, stealing from the
+    // longest other queue when its own is empty.
+    bool TakeWork(DeviceContext* ctx, WorkItem& item);
+
+    wgpu::Instance instance_;
+    std::vector<std::unique_ptr<DeviceContext>> devices_;
+
+    std::mutex mutex_;
+    std::condition_variable work_cv_;
+    std::condition_variable drain_cv_;
+    int busy_workers_ = 0;
+    size_t enqueue_cursor_ = 0;  // round-robin target for EnqueueImage
+    bool stop_ = false;
+
+    std::mutex results_mutex_;
+    std::vector<SchedulerResult> results_;
+};
+
+#endif  // WEBSIFTGPU_CPP_SRC_SIFT_SCHEDULER_H_
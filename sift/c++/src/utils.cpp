@@ -1,9 +1,20 @@
 #include "utils.h"
+#include <cstring>
 #include <fstream>
 #include <iostream>
 #include <sstream>
 #include <stdexcept>
 
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
 #define STB_IMAGE_IMPLEMENTATION
 #include "stb_image.h"
 
@@ -34,8 +45,245 @@ std::vector<uint8_t> loadImage(const std::string& path, int* width, int* height)
     return result;
 }
 
+std::vector<uint8_t> loadImageGray(const std::string& path, int* width, int* height) {
+    int channels;
+    // Force 1 channel; stb does the luma conversion for color sources
+    unsigned char* data = stbi_load(path.c_str(), width, height, &channels, 1);
+    if (!data) {
+        throw std::runtime_error("Failed to load image: " + path);
+    }
+    std::vector<uint8_t> result(data, data + (size_t)(*width) * (*height));
+    stbi_image_free(data);
+    return result;
+}
+
 void saveImage(const std::string& path, const uint8_t* data, int width, int height) {
     stbi_write_png(path.c_str(), width, height, 4, data, width * 4);
 }
 
+LoadedImage::~LoadedImage() {
+    if (pixels) stbi_image_free(pixels);
+}
+
+LoadedImage::LoadedImage(LoadedImage&& other) noexcept
+    : path(std::move(other.path)), width(other.width), height(other.height),
+      pixels(other.pixels), ok(other.ok) {
+    other.pixels = nullptr;
+}
+
+LoadedImage& LoadedImage::operator=(LoadedImage&& other) noexcept {
+    if (this != &other) {
+        if (pixels) stbi_image_free(pixels);
+        path = std::move(other.path);
+        width = other.width;
+        height = other.height;
+        pixels = other.pixels;
+        ok = other.ok;
+        other.pixels = nullptr;
+    }
+    return *this;
+}
+
+ImageBatchLoader::ImageBatchLoader(std::vector<std::string> paths, int channels,
+                                   int prefetch, int num_threads)
+    : paths_(std::move(paths)), channels_(channels),
+      prefetch_(prefetch > 0 ? (size_t)prefetch : 1) {
+    slots_.resize(paths_.size());
+    slot_done_.assign(paths_.size(), 0);
+
+    int n = num_threads;
+    if (n <= 0) n = (int)std::thread::hardware_concurrency() - 1;
+    if (n < 1) n = 1;
+    if ((size_t)n > paths_.size()) n = (int)paths_.size();
+    for (int i = 0; i < n; ++i) {
+        workers_.emplace_back(&ImageBatchLoader::WorkerLoop, this);
+    }
+}
+
+ImageBatchLoader::~ImageBatchLoader() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    space_cv_.notify_all();
+    for (auto& w : workers_) w.join();
+}
+
+void ImageBatchLoader::WorkerLoop() {
+    for (;;) {
+        size_t idx;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            space_cv_.wait(lock, [&] {
+                return stop_ || (next_claim_ < paths_.size() &&
+                                 next_claim_ < consumed_ + prefetch_);
+            });
+            if (stop_ || next_claim_ >= paths_.size()) return;
+            idx = next_claim_++;
+        }
+
+        // Decode outside the lock; this is where the time goes.
+        LoadedImage img;
+        img.path = paths_[idx];
+        int channels;
+        img.pixels = stbi_load(img.path.c_str(), &img.width, &img.height,
+                               &channels, channels_);
+        img.ok = img.pixels != nullptr;
+        if (!img.ok) {
+            std::cerr << "[ImageBatchLoader] Failed to load image: " << img.path << std::endl;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            slots_[idx] = std::move(img);
+            slot_done_[idx] = 1;
+        }
+        ready_cv_.notify_all();
+    }
+}
+
+bool ImageBatchLoader::next(LoadedImage& out) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (consumed_ >= paths_.size()) return false;
+    size_t idx = consumed_;
+    ready_cv_.wait(lock, [&] { return slot_done_[idx] != 0; });
+    out = std::move(slots_[idx]);
+    consumed_++;
+    lock.unlock();
+    // Consuming an image widens the prefetch window
+    space_cv_.notify_all();
+    return true;
+}
+
+void writeFeatures(const std::string& path, const std::vector<Keypoint>& keypoints,
+                   const void* descriptors, DescriptorType type) {
+    uint32_t count = (uint32_t)keypoints.size();
+    size_t desc_elem_size = type == DescriptorType::Float32 ? 128 * sizeof(float)
+                          : type == DescriptorType::Uint8 ? 128
+                          : 0;
+
+    FeatureFileHeader header;
+    std::memcpy(header.magic, "WSFT", 4);
+    header.version = 1;
+    header.keypoint_count = count;
+    header.descriptor_type = (uint32_t)type;
+    header.keypoint_offset = sizeof(FeatureFileHeader);
+    header.descriptor_offset = header.keypoint_offset + (uint64_t)count * sizeof(KeypointRecord);
+
+    std::ofstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        throw std::runtime_error("Failed to open file for writing: " + path);
+    }
+    file.write((const char*)&header, sizeof(header));
+
+    // Expand the 24-byte host Keypoint to the 32-byte GPU record so the
+    // reader can hand the array straight to GPU uploads or SIMD loops.
+    std::vector<KeypointRecord> records(count);
+    for (uint32_t i = 0; i < count; ++i) {
+        const Keypoint& kp = keypoints[i];
+        records[i] = { kp.x, kp.y, kp.octave, kp.scale, kp.sigma, kp.orientation, 0.0f, 0.0f };
+    }
+    file.write((const char*)records.data(), (std::streamsize)(count * sizeof(KeypointRecord)));
+
+    if (desc_elem_size > 0 && descriptors) {
+        file.write((const char*)descriptors, (std::streamsize)((size_t)count * desc_elem_size));
+    }
+}
+
+FeatureFileReader::~FeatureFileReader() { close(); }
+
+bool FeatureFileReader::open(const std::string& path) {
+    close();
+
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                              OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        std::cerr << "[FeatureFileReader] Failed to open " << path << std::endl;
+        return false;
+    }
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size) || size.QuadPart < (LONGLONG)sizeof(FeatureFileHeader)) {
+        CloseHandle(file);
+        std::cerr << "[FeatureFileReader] " << path << " is not a feature file" << std::endl;
+        return false;
+    }
+    HANDLE map = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!map) {
+        CloseHandle(file);
+        return false;
+    }
+    void* base = MapViewOfFile(map, FILE_MAP_READ, 0, 0, 0);
+    if (!base) {
+        CloseHandle(map);
+        CloseHandle(file);
+        return false;
+    }
+    file_handle_ = file;
+    map_handle_ = map;
+    mapping_ = base;
+    mapping_size_ = (size_t)size.QuadPart;
+#else
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        std::cerr << "[FeatureFileReader] Failed to open " << path << std::endl;
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(FeatureFileHeader)) {
+        ::close(fd);
+        std::cerr << "[FeatureFileReader] " << path << " is not a feature file" << std::endl;
+        return false;
+    }
+    void* base = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (base == MAP_FAILED) {
+        ::close(fd);
+        return false;
+    }
+    fd_ = fd;
+    mapping_ = base;
+    mapping_size_ = (size_t)st.st_size;
+#endif
+
+    const FeatureFileHeader* header = (const FeatureFileHeader*)mapping_;
+    size_t desc_elem_size = header->descriptor_type == (uint32_t)DescriptorType::Float32 ? 128 * sizeof(float)
+                          : header->descriptor_type == (uint32_t)DescriptorType::Uint8 ? 128
+                          : 0;
+    uint64_t needed = header->keypoint_offset + (uint64_t)header->keypoint_count * sizeof(KeypointRecord);
+    if (desc_elem_size > 0) {
+        needed = header->descriptor_offset + (uint64_t)header->keypoint_count * desc_elem_size;
+    }
+    if (std::memcmp(header->magic, "WSFT", 4) != 0 || header->version != 1 || needed > mapping_size_) {
+        std::cerr << "[FeatureFileReader] " << path << " has a bad header" << std::endl;
+        close();
+        return false;
+    }
+
+    header_ = header;
+    keypoints_ = (const KeypointRecord*)((const uint8_t*)mapping_ + header->keypoint_offset);
+    descriptors_ = desc_elem_size > 0 ? (const uint8_t*)mapping_ + header->descriptor_offset : nullptr;
+    return true;
+}
+
+void FeatureFileReader::close() {
+    if (mapping_) {
+#ifdef _WIN32
+        UnmapViewOfFile(mapping_);
+        CloseHandle(map_handle_);
+        CloseHandle(file_handle_);
+        map_handle_ = nullptr;
+        file_handle_ = nullptr;
+#else
+        munmap(mapping_, mapping_size_);
+        ::close(fd_);
+        fd_ = -1;
+#endif
+        mapping_ = nullptr;
+    }
+    mapping_size_ = 0;
+    header_ = nullptr;
+    keypoints_ = nullptr;
+    descriptors_ = nullptr;
+}
+
 }  // namespace utils
@@ -4,6 +4,11 @@
 #include <string>
 #include <vector>
 #include <cstdint>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#include "sift_base.h"
 
 namespace utils {
 
@@ -13,9 +18,155 @@ std::string readFile(const std::string& path);
 // Loads image as RGBA8
 std::vector<uint8_t> loadImage(const std::string& path, int* width, int* height);
 
+// Loads image as single-channel 8-bit luma, for engines running with
+// SIFTOptions::grayscaleInput (1 byte per pixel upload).
+std::vector<uint8_t> loadImageGray(const std::string& path, int* width, int* height);
+
 // Saves RGBA8 image to PNG
 void saveImage(const std::string& path, const uint8_t* data, int width, int height);
 
+// --- Batch image loading ---
+//
+// Decode dominates wall time on directory-sized batch jobs when done one
+// file at a time on the calling thread. ImageBatchLoader decodes a list of
+// files on a small thread pool, a bounded number of images ahead of the
+// consumer, and hands back the stbi allocation itself instead of copying it
+// into a vector. next() returns images in list order, so results can feed
+// DetectKeypoints while later files are still decoding.
+
+// Owns the decoded pixel allocation (freed on destruction); movable only.
+struct LoadedImage {
+    std::string path;
+    int width = 0;
+    int height = 0;
+    uint8_t* pixels = nullptr;
+    bool ok = false;
+
+    LoadedImage() = default;
+    ~LoadedImage();
+    LoadedImage(LoadedImage&& other) noexcept;
+    LoadedImage& operator=(LoadedImage&& other) noexcept;
+    LoadedImage(const LoadedImage&) = delete;
+    LoadedImage& operator=(const LoadedImage&) = delete;
+};
+
+class ImageBatchLoader {
+ public:
+    // channels: 4 for RGBA8, 1 for 8-bit luma (SIFTOptions::grayscaleInput).
+    // prefetch bounds how far decode may run ahead of next(); num_threads 0
+    // picks hardware_concurrency - 1.
+    ImageBatchLoader(std::vector<std::string> paths, int channels = 4,
+                     int prefetch = 8, int num_threads = 0);
+    ~ImageBatchLoader();
+    ImageBatchLoader(const ImageBatchLoader&) = delete;
+    ImageBatchLoader& operator=(const ImageBatchLoader&) = delete;
+
+    // Next image in list order; blocks until it is decoded. Returns false
+    // once the list is exhausted. Failed decodes come back with ok == false
+    // rather than throwing, so one bad file doesn't abort a long batch.
+    bool next(LoadedImage& out);
+
+ private:
+    void WorkerLoop();
+
+    std::vector<std::string> paths_;
+    int channels_;
+    size_t prefetch_;
+
+    std::mutex mutex_;
+    std::condition_variable ready_cv_;  // Consumer waits for its slot
+    std::condition_variable space_cv_;  // Workers wait for the prefetch window
+    std::vector<LoadedImage> slots_;
+    std::vector<char> slot_done_;
+    size_t next_claim_ = 0;   // Next index a worker will decode
+    size_t consumed_ = 0;     // Next index next() will hand out
+    bool stop_ = false;
+    std::vector<std::thread> workers_;
+};
+
+// --- Binary feature files ---
+//
+// Compact on-disk format for keypoints + descriptors, replacing the JSON
+// output for pipelines that re-load features constantly. Layout:
+//   FeatureFileHeader
+//   keypoint_count x KeypointRecord (the 32-byte GPU keypoint layout)
+//   descriptor block (keypoint_count x 128 f32, or x 128 u8 when quantized)
+// Everything is little-endian and written with natural alignment, so a
+// memory-mapped file can be read in place with zero parsing.
+
+enum class DescriptorType : uint32_t {
+    None = 0,
+    Float32 = 1,  // 128 f32 per keypoint
+    Uint8 = 2,    // 128 u8 per keypoint (quantized)
+};
+
+// Matches the GPU-side Keypoint struct in structs.wgsl (32 bytes).
+struct KeypointRecord {
+    float x;
+    float y;
+    float octave;
+    float scale;
+    float sigma;
+    float orientation;
+    float response;  // |DoG| contrast response (p1 on the GPU)
+    float pad;
+};
+
+struct FeatureFileHeader {
+    char magic[4];           // "WSFT"
+    uint32_t version;        // 1
+    uint32_t keypoint_count;
+    uint32_t descriptor_type;  // DescriptorType
+    uint64_t keypoint_offset;  // byte offset of the KeypointRecord array
+    uint64_t descriptor_offset;
+};
+
+// Writes keypoints + descriptors to `path`. `descriptors` may be null with
+// DescriptorType::None; otherwise it must hold keypoint_count x 128
+// elements of the given type.
+void writeFeatures(const std::string& path, const std::vector<Keypoint>& keypoints,
+                   const void* descriptors, DescriptorType type);
+
+// Zero-copy reader: maps the file and hands out pointers directly into the
+// mapping, so "loading" a feature file is just page faults as the matcher
+// touches descriptors. Pointers stay valid until close()/destruction.
+class FeatureFileReader {
+ public:
+    FeatureFileReader() = default;
+    ~FeatureFileReader();
+    FeatureFileReader(const FeatureFileReader&) = delete;
+    FeatureFileReader& operator=(const FeatureFileReader&) = delete;
+
+    // Returns false (and logs) on open/validation failure.
+    bool open(const std::string& path);
+    void close();
+
+    uint32_t count() const { return header_ ? header_->keypoint_count : 0; }
+    DescriptorType descriptorType() const {
+        return header_ ? (DescriptorType)header_->descriptor_type : DescriptorType::None;
+    }
+    const KeypointRecord* keypoints() const { return keypoints_; }
+    const float* descriptorsF32() const {
+        return descriptorType() == DescriptorType::Float32 ? (const float*)descriptors_ : nullptr;
+    }
+    const uint8_t* descriptorsU8() const {
+        return descriptorType() == DescriptorType::Uint8 ? (const uint8_t*)descriptors_ : nullptr;
+    }
+
+ private:
+    const FeatureFileHeader* header_ = nullptr;
+    const KeypointRecord* keypoints_ = nullptr;
+    const void* descriptors_ = nullptr;
+    void* mapping_ = nullptr;
+    size_t mapping_size_ = 0;
+#ifdef _WIN32
+    void* file_handle_ = nullptr;
+    void* map_handle_ = nullptr;
+#else
+    int fd_ = -1;
+#endif
+};
+
 }  // namespace utils
 
 #endif  // WEBSIFTGPU_CPP_SRC_UTILS_H_
@@ -0,0 +1,93 @@
+// Bins keypoint indices by octave and emits per-octave indirect dispatch
+// arguments, replacing prepare_dispatch.wgsl for engines that use the binned
+// orientation/descriptor shaders. With a single global dispatch every octave
+// pass visits the full keypoint list and early-outs on octave mismatch; with
+// binning each keypoint is processed exactly once.
+
+// Buffer layout capacity; the octave count actually in use is specialized at
+// pipeline creation (SIFTOptions::numOctaves) and only affects loop bounds,
+// so the buffer layout is independent of the deployment tier.
+const MAX_OCTAVES: u32 = 8u;
+override NUM_OCTAVES: u32 = 4u;
+const WG_SIZE: u32 = 256u;
+
+struct Keypoint {
+    x: f32, y: f32, octave: f32, scale: f32, sigma: f32, orientation: f32, p1: f32, p2: f32
+}
+
+struct KeypointList {
+    count: atomic<u32>, pad1: u32, pad2: u32, pad3: u32, points: array<Keypoint>
+}
+
+// counts/offsets describe the per-octave partition of indices; cursors are
+// the scatter write positions (seeded with the offsets below).
+struct OctaveBins {
+    counts: array<atomic<u32>, MAX_OCTAVES>,
+    offsets: array<u32, MAX_OCTAVES>,
+    cursors: array<atomic<u32>, MAX_OCTAVES>,
+    indices: array<u32>
+}
+
+// Per-octave dispatch args, 3 u32 each: MAX_OCTAVES orientation entries
+// followed by MAX_OCTAVES descriptor entries.
+struct DispatchArgs {
+    args: array<u32, 48>
+}
+
+@group(0) @binding(0) var<storage, read_write> keypoints: KeypointList;
+@group(0) @binding(1) var<storage, read_write> bins: OctaveBins;
+@group(0) @binding(2) var<storage, read_write> dispatch_args: DispatchArgs;
+
+// Single workgroup: count, prefix-sum and scatter stay in one dispatch so no
+// host round trip or extra pipeline is needed between the phases.
+@compute @workgroup_size(WG_SIZE)
+fn main(@builtin(local_invocation_index) lid: u32) {
+    if (lid < NUM_OCTAVES) {
+        atomicStore(&bins.counts[lid], 0u);
+    }
+    // The recorded count can exceed the buffer capacity on keypoint-heavy
+    // frames; clamp to what the index array can actually hold.
+    let count = min(atomicLoad(&keypoints.count), arrayLength(&bins.indices));
+    storageBarrier();
+
+    for (var i = lid; i < count; i += WG_SIZE) {
+        let o = min(u32(keypoints.points[i].octave), NUM_OCTAVES - 1u);
+        atomicAdd(&bins.counts[o], 1u);
+    }
+    storageBarrier();
+
+    if (lid == 0u) {
+        var offset = 0u;
+        for (var o = 0u; o < NUM_OCTAVES; o++) {
+            let c = atomicLoad(&bins.counts[o]);
+            bins.offsets[o] = offset;
+            atomicStore(&bins.cursors[o], offset);
+            offset += c;
+
+            // Orientation: 1 keypoint per workgroup, 2D dispatch for large
+            // counts. Matches: let slot = wid.x + wid.y * 65535u
+            let ori = max(c, 1u);
+            if (ori <= 65535u) {
+                dispatch_args.args[o * 3u] = ori;
+                dispatch_args.args[o * 3u + 1u] = 1u;
+            } else {
+                dispatch_args.args[o * 3u] = 65535u;
+                dispatch_args.args[o * 3u + 1u] = (ori + 65534u) / 65535u;
+            }
+            dispatch_args.args[o * 3u + 2u] = 1u;
+
+            // Descriptor: 64 keypoints per workgroup (workgroup_size(64))
+            let d = (MAX_OCTAVES + o) * 3u;
+            dispatch_args.args[d] = max((c + 63u) / 64u, 1u);
+            dispatch_args.args[d + 1u] = 1u;
+            dispatch_args.args[d + 2u] = 1u;
+        }
+    }
+    storageBarrier();
+
+    for (var i = lid; i < count; i += WG_SIZE) {
+        let o = min(u32(keypoints.points[i].octave), NUM_OCTAVES - 1u);
+        let slot = atomicAdd(&bins.cursors[o], 1u);
+        bins.indices[slot] = i;
+    }
+}
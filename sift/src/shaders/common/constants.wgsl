@@ -2,7 +2,9 @@ const PI: f32 = 3.141592653589793;
 const TWO_PI: f32 = 6.283185307179586;
 
 const SIGMA_BASE: f32 = 1.6;
-const SCALES_PER_OCTAVE: f32 = 3.0;
+// Specializable at pipeline creation (WGSL override); the C++ engines set it
+// from SIFTOptions::scalesPerOctave, JS uses the default.
+override SCALES_PER_OCTAVE: f32 = 3.0;
 
 const ORI_BINS: u32 = 36u;
 const ORI_PEAK_RATIO: f32 = 0.8;
@@ -0,0 +1,90 @@
+// GPU top-K keypoint selection: keeps the ~K strongest keypoints by contrast
+// response (|DoG| recorded in Keypoint.p1 by extrema.wgsl) so the
+// orientation/descriptor passes and the readback scale with K instead of the
+// raw extrema count. Threshold refinement over a response histogram rather
+// than a full sort: one single-workgroup dispatch, same shape as
+// bin_keypoints.wgsl.
+
+const WG_SIZE: u32 = 256u;
+const HIST_BINS: u32 = 256u;
+
+struct Params {
+    maxKeypoints: u32, pad1: u32, pad2: u32, pad3: u32
+}
+
+struct Keypoint {
+    x: f32, y: f32, octave: f32, scale: f32, sigma: f32, orientation: f32, p1: f32, p2: f32
+}
+
+struct KeypointList {
+    count: atomic<u32>, pad1: u32, pad2: u32, pad3: u32, points: array<Keypoint>
+}
+
+@group(0) @binding(0) var<uniform> params: Params;
+@group(0) @binding(1) var<storage, read_write> keypoints: KeypointList;
+@group(0) @binding(2) var<storage, read_write> selected: KeypointList;
+
+var<workgroup> wgHist: array<atomic<u32>, HIST_BINS>;
+var<workgroup> wgMaxBits: atomic<u32>;
+var<workgroup> wgTau: f32;
+
+@compute @workgroup_size(WG_SIZE)
+fn main(@builtin(local_invocation_index) lid: u32) {
+    let total = min(atomicLoad(&keypoints.count), arrayLength(&keypoints.points));
+    let k = params.maxKeypoints;
+
+    // HIST_BINS == WG_SIZE: one bin per thread to zero
+    atomicStore(&wgHist[lid], 0u);
+    if (lid == 0u) {
+        atomicStore(&wgMaxBits, 0u);
+        atomicStore(&selected.count, 0u);
+    }
+    workgroupBarrier();
+
+    // Max response; p1 is non-negative so f32 bits order like u32
+    for (var i = lid; i < total; i += WG_SIZE) {
+        atomicMax(&wgMaxBits, bitcast<u32>(keypoints.points[i].p1));
+    }
+    workgroupBarrier();
+    let maxResp = bitcast<f32>(atomicLoad(&wgMaxBits));
+
+    for (var i = lid; i < total; i += WG_SIZE) {
+        let b = min(u32(keypoints.points[i].p1 / max(maxResp, 1e-20) * f32(HIST_BINS)), HIST_BINS - 1u);
+        atomicAdd(&wgHist[b], 1u);
+    }
+    workgroupBarrier();
+
+    if (lid == 0u) {
+        // Walk bins strongest-first until k is covered; tau is that bin's
+        // lower edge. The boundary bin can overshoot, compaction clamps to k.
+        var tau = 0.0;
+        if (total > k) {
+            var cum = 0u;
+            var b = i32(HIST_BINS) - 1;
+            loop {
+                cum += atomicLoad(&wgHist[b]);
+                if (cum >= k || b == 0) { break; }
+                b -= 1;
+            }
+            tau = f32(b) / f32(HIST_BINS) * maxResp;
+        }
+        wgTau = tau;
+    }
+    workgroupBarrier();
+    let tau = wgTau;
+
+    for (var i = lid; i < total; i += WG_SIZE) {
+        let kp = keypoints.points[i];
+        if (kp.p1 >= tau) {
+            let slot = atomicAdd(&selected.count, 1u);
+            if (slot < k) {
+                selected.points[slot] = kp;
+            }
+        }
+    }
+    storageBarrier();
+
+    if (lid == 0u) {
+        atomicStore(&selected.count, min(atomicLoad(&selected.count), k));
+    }
+}
@@ -98,6 +98,9 @@ fn main(@builtin(global_invocation_id) gid: vec3u, @builtin(local_invocation_ind
 
     if (isFeature) {
         let idx = wgGlobalOffset + myWgIdx;
+        // count keeps incrementing past the buffer capacity so the host can
+        // report attempted vs. stored; readers clamp to the capacity.
+        if (idx >= arrayLength(&keypoints.points)) { return; }
         // Write keypoint
         let scaleMult = pow(2.0, f32(params.octave));
         keypoints.points[idx].x = f32(x) * scaleMult;
@@ -99,15 +99,20 @@ fn checkKeypoint(x: i32, y: i32) {
     let r = params.edgeThreshold;
     
     if (det > 0.0 && (tr * tr * r) < ((r + 1.0) * (r + 1.0) * det)) {
-        // Add Keypoint
+        // Add Keypoint. count keeps incrementing past the buffer capacity so
+        // the host can report attempted vs. stored (saturation telemetry);
+        // every consumer clamps to min(count, arrayLength).
         let globalIdx = atomicAdd(&keypoints.count, 1u);
+        if (globalIdx >= arrayLength(&keypoints.points)) { return; }
         let scaleMult = pow(2.0, f32(params.octave));
-        
+
         keypoints.points[globalIdx].x = f32(x) * scaleMult;
         keypoints.points[globalIdx].y = f32(y) * scaleMult;
         keypoints.points[globalIdx].octave = f32(params.octave);
         keypoints.points[globalIdx].scale = f32(params.scale);
         keypoints.points[globalIdx].sigma = SIGMA_BASE * pow(2.0, (f32(params.scale) / SCALES_PER_OCTAVE)) * scaleMult;
         keypoints.points[globalIdx].orientation = 0.0;
+        // Contrast response, consumed by select_keypoints.wgsl for top-K selection
+        keypoints.points[globalIdx].p1 = abs(val);
     }
 }
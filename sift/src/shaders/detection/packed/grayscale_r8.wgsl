@@ -0,0 +1,32 @@
+// Single-channel input variant of grayscale.wgsl (SIFTOptions::grayscaleInput):
+// the input texture is r8unorm (camera Y plane uploaded as-is, 1 byte per
+// pixel instead of 4), so the luma conversion drops away and only the 2x2
+// packing step remains. Same bindings as grayscale.wgsl.
+@group(0) @binding(0) var inputTex: texture_2d<f32>;
+@group(0) @binding(1) var outputTex: texture_storage_2d<rgba32float, write>;
+
+// Workgroup sizes can be specialized if needed for different GPU architectures.
+override WG_SIZE_X: u32 = 16u;
+override WG_SIZE_Y: u32 = 16u;
+
+@compute @workgroup_size(WG_SIZE_X, WG_SIZE_Y)
+fn main(@builtin(global_invocation_id) gid: vec3u) {
+    // gid describes the PACKED coordinates (w/2, h/2)
+    let px = i32(gid.x);
+    let py = i32(gid.y);
+
+    let outDims = textureDimensions(outputTex);
+    if (px >= i32(outDims.x) || py >= i32(outDims.y)) { return; }
+
+    // Src coords (2x2 block)
+    let sx = px * 2;
+    let sy = py * 2;
+
+    let g00 = textureLoad(inputTex, vec2i(sx, sy), 0).r;
+    let g10 = textureLoad(inputTex, vec2i(sx+1, sy), 0).r;
+    let g01 = textureLoad(inputTex, vec2i(sx, sy+1), 0).r;
+    let g11 = textureLoad(inputTex, vec2i(sx+1, sy+1), 0).r;
+
+    // Pack: x=(0,0), y=(1,0), z=(0,1), w=(1,1)
+    textureStore(outputTex, vec2i(px, py), vec4f(g00, g10, g01, g11));
+}
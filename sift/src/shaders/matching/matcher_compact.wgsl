@@ -0,0 +1,48 @@
+struct Params {
+    countA: u32,
+    pad1: u32,
+    ratioSq: f32,
+    pad2: f32
+}
+
+#include "../common/structs.wgsl"
+#include "../common/constants.wgsl"
+
+// Applies Lowe's ratio test on the GPU and compacts surviving matches with
+// an atomic write index — the same append pattern extrema.wgsl uses for the
+// keypoint buffer. Typically <15% of queries survive, so the host reads
+// back count * 16 bytes instead of the full per-query result array.
+
+struct CompactMatch {
+    queryIdx: i32,
+    trainIdx: i32,
+    distSq: f32,
+    pad: f32
+}
+
+struct CompactMatchList {
+    count: atomic<u32>,
+    pad1: u32,
+    pad2: u32,
+    pad3: u32,
+    matches: array<CompactMatch>
+}
+
+@group(0) @binding(0) var<uniform> params: Params;
+@group(0) @binding(1) var<storage, read> results: array<MatchResult>;
+@group(0) @binding(2) var<storage, read_write> compacted: CompactMatchList;
+
+@compute @workgroup_size(64)
+fn main(@builtin(global_invocation_id) gid: vec3u) {
+    let i = gid.x;
+    if (i >= params.countA) { return; }
+
+    let r = results[i];
+    if (r.bestIdx >= 0 && r.bestDistSq < params.ratioSq * r.secondDistSq) {
+        let slot = atomicAdd(&compacted.count, 1u);
+        compacted.matches[slot].queryIdx = i32(i);
+        compacted.matches[slot].trainIdx = r.bestIdx;
+        compacted.matches[slot].distSq = r.bestDistSq;
+        compacted.matches[slot].pad = 0.0;
+    }
+}
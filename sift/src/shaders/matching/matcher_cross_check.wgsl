@@ -0,0 +1,51 @@
+struct Params {
+    countA: u32,
+    pad1: u32,
+    ratioSq: f32,
+    pad2: f32
+}
+
+#include "../common/structs.wgsl"
+#include "../common/constants.wgsl"
+
+// Mutual-best (cross-check) filter: given per-query results for both
+// directions, emit only matches where A's best in B also picked A back,
+// with the ratio test applied on the A->B side. Replaces the host-side
+// intersection of two MatchDescriptors calls.
+
+struct CompactMatch {
+    queryIdx: i32,
+    trainIdx: i32,
+    distSq: f32,
+    pad: f32
+}
+
+struct CompactMatchList {
+    count: atomic<u32>,
+    pad1: u32,
+    pad2: u32,
+    pad3: u32,
+    matches: array<CompactMatch>
+}
+
+@group(0) @binding(0) var<uniform> params: Params;
+@group(0) @binding(1) var<storage, read> resultsAB: array<MatchResult>;
+@group(0) @binding(2) var<storage, read> resultsBA: array<MatchResult>;
+@group(0) @binding(3) var<storage, read_write> compacted: CompactMatchList;
+
+@compute @workgroup_size(64)
+fn main(@builtin(global_invocation_id) gid: vec3u) {
+    let i = gid.x;
+    if (i >= params.countA) { return; }
+
+    let fwd = resultsAB[i];
+    if (fwd.bestIdx < 0) { return; }
+    if (fwd.bestDistSq >= params.ratioSq * fwd.secondDistSq) { return; }
+    if (resultsBA[fwd.bestIdx].bestIdx != i32(i)) { return; }
+
+    let slot = atomicAdd(&compacted.count, 1u);
+    compacted.matches[slot].queryIdx = i32(i);
+    compacted.matches[slot].trainIdx = fwd.bestIdx;
+    compacted.matches[slot].distSq = fwd.bestDistSq;
+    compacted.matches[slot].pad = 0.0;
+}
@@ -0,0 +1,94 @@
+struct Params {
+    countQ: u32,
+    numCells: u32,
+    nprobe: u32,
+    pad: u32
+}
+
+#include "../common/structs.wgsl"
+#include "../common/constants.wgsl"
+
+// IVF probe matching: one thread per query ranks all cell centroids, then
+// scans only the nprobe nearest cells' descriptors (stored contiguously per
+// cell by BuildIndex), instead of the whole library — sub-linear in library
+// size at the cost of missing matches whose cell wasn't probed. Results use
+// original library indexing (via cellEntries) and the same MatchResult
+// layout as matcher.wgsl, so the ratio-test/compaction pass is shared with
+// the brute-force path.
+
+@group(0) @binding(0) var<uniform> params: Params;
+@group(0) @binding(1) var<storage, read> queries: array<f32>;
+@group(0) @binding(2) var<storage, read> centroids: array<f32>;
+@group(0) @binding(3) var<storage, read> cellOffsets: array<u32>;   // numCells + 1, CSR
+@group(0) @binding(4) var<storage, read> cellEntries: array<u32>;   // original library index per slot
+@group(0) @binding(5) var<storage, read> cellDescriptors: array<f32>; // library reordered by cell
+@group(0) @binding(6) var<storage, read_write> results: array<MatchResult>;
+
+// Upper bound on the probe list kept in registers; params.nprobe is clamped.
+const MAX_PROBE: u32 = 16u;
+
+// Workgroup sizes can be specialized if needed for different GPU architectures.
+override WG_SIZE: u32 = 64u;
+
+@compute @workgroup_size(WG_SIZE)
+fn main(@builtin(global_invocation_id) gid: vec3u) {
+    let q = gid.x;
+    if (q >= params.countQ) { return; }
+
+    let nprobe = min(max(params.nprobe, 1u), min(MAX_PROBE, params.numCells));
+
+    // Rank centroids, keeping the nprobe nearest by insertion into a small
+    // sorted list.
+    var probeCell: array<u32, MAX_PROBE>;
+    var probeDist: array<f32, MAX_PROBE>;
+    for (var p = 0u; p < nprobe; p++) {
+        probeCell[p] = 0u;
+        probeDist[p] = 1e30;
+    }
+    for (var c = 0u; c < params.numCells; c++) {
+        var distSq = 0.0;
+        for (var k = 0u; k < DESC_DIM; k++) {
+            let diff = queries[q * DESC_DIM + k] - centroids[c * DESC_DIM + k];
+            distSq += diff * diff;
+        }
+        if (distSq < probeDist[nprobe - 1u]) {
+            var j = nprobe - 1u;
+            loop {
+                if (j == 0u || probeDist[j - 1u] <= distSq) { break; }
+                probeDist[j] = probeDist[j - 1u];
+                probeCell[j] = probeCell[j - 1u];
+                j -= 1u;
+            }
+            probeDist[j] = distSq;
+            probeCell[j] = c;
+        }
+    }
+
+    // Scan the probed cells' descriptors
+    var bestDistSq = 1e30;
+    var secondDistSq = 1e30;
+    var bestIdx = -1;
+    for (var p = 0u; p < nprobe; p++) {
+        let cell = probeCell[p];
+        let begin = cellOffsets[cell];
+        let end = cellOffsets[cell + 1u];
+        for (var i = begin; i < end; i++) {
+            var distSq = 0.0;
+            for (var k = 0u; k < DESC_DIM; k++) {
+                let diff = queries[q * DESC_DIM + k] - cellDescriptors[i * DESC_DIM + k];
+                distSq += diff * diff;
+            }
+            if (distSq < bestDistSq) {
+                secondDistSq = bestDistSq;
+                bestDistSq = distSq;
+                bestIdx = i32(cellEntries[i]);
+            } else if (distSq < secondDistSq) {
+                secondDistSq = distSq;
+            }
+        }
+    }
+
+    results[q].bestIdx = bestIdx;
+    results[q].bestDistSq = bestDistSq;
+    results[q].secondDistSq = secondDistSq;
+}
@@ -0,0 +1,42 @@
+struct Params {
+    count: u32,
+    numCells: u32,
+    pad1: u32,
+    pad2: u32
+}
+
+#include "../common/constants.wgsl"
+
+// K-means assignment step for the IVF coarse index (SIFTMatcher::BuildIndex):
+// one thread per library descriptor finds its nearest cell centroid. The
+// centroid update runs on the host from the read-back assignments, so this
+// is the only GPU pass per iteration.
+
+@group(0) @binding(0) var<uniform> params: Params;
+@group(0) @binding(1) var<storage, read> descriptors: array<f32>;
+@group(0) @binding(2) var<storage, read> centroids: array<f32>;
+@group(0) @binding(3) var<storage, read_write> assignments: array<u32>;
+
+// Workgroup sizes can be specialized if needed for different GPU architectures.
+override WG_SIZE: u32 = 64u;
+
+@compute @workgroup_size(WG_SIZE)
+fn main(@builtin(global_invocation_id) gid: vec3u) {
+    let idx = gid.x;
+    if (idx >= params.count) { return; }
+
+    var bestDistSq = 1e30;
+    var bestCell = 0u;
+    for (var c = 0u; c < params.numCells; c++) {
+        var distSq = 0.0;
+        for (var k = 0u; k < DESC_DIM; k++) {
+            let diff = descriptors[idx * DESC_DIM + k] - centroids[c * DESC_DIM + k];
+            distSq += diff * diff;
+        }
+        if (distSq < bestDistSq) {
+            bestDistSq = distSq;
+            bestCell = c;
+        }
+    }
+    assignments[idx] = bestCell;
+}
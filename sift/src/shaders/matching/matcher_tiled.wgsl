@@ -0,0 +1,79 @@
+struct Params {
+    countA: u32,
+    countB: u32,
+    pad1: u32,
+    pad2: u32
+}
+
+#include "../common/structs.wgsl"
+#include "../common/constants.wgsl"
+
+@group(0) @binding(0) var<uniform> params: Params;
+@group(0) @binding(1) var<storage, read> descriptorsA: array<f32>;
+@group(0) @binding(2) var<storage, read> descriptorsB: array<f32>;
+@group(0) @binding(3) var<storage, read_write> results: array<MatchResult>;
+
+// Tiled variant of matcher.wgsl for large descriptor sets: the workgroup
+// cooperatively stages B-descriptor tiles in workgroup memory so every B
+// descriptor is read from global memory once per workgroup instead of once
+// per thread. Past ~20k x 20k descriptors this is the difference between
+// bandwidth-bound and compute-bound.
+
+const TILE_B: u32 = 24u;        // Descriptors per tile
+const WG_SIZE_TILED: u32 = 64u; // Threads (queries) per workgroup
+
+// TILE_B * DESC_DIM floats = 12 KB, inside the 16 KB default workgroup
+// storage limit with headroom.
+var<workgroup> tileB: array<f32, 3072>;
+
+@compute @workgroup_size(64)
+fn main(@builtin(global_invocation_id) gid: vec3u, @builtin(local_invocation_index) lid: u32) {
+    let idxA = gid.x;
+    let active = idxA < params.countA;
+
+    var bestDistSq = 1e30;
+    var secondDistSq = 1e30;
+    var bestIdx = -1;
+
+    // The tile loop bound derives from a uniform, so all threads (including
+    // out-of-range ones) reach the barriers.
+    let numTiles = (params.countB + TILE_B - 1u) / TILE_B;
+    for (var t = 0u; t < numTiles; t++) {
+        let tileStart = t * TILE_B;
+        let tileCount = min(TILE_B, params.countB - tileStart);
+
+        // Cooperative load: TILE_B * DESC_DIM elements spread over the workgroup
+        for (var e = lid; e < TILE_B * DESC_DIM; e += WG_SIZE_TILED) {
+            let d = e / DESC_DIM;
+            let k = e % DESC_DIM;
+            if (d < tileCount) {
+                tileB[e] = descriptorsB[(tileStart + d) * DESC_DIM + k];
+            }
+        }
+        workgroupBarrier();
+
+        if (active) {
+            for (var i = 0u; i < tileCount; i++) {
+                var distSq = 0.0;
+                for (var k = 0u; k < DESC_DIM; k++) {
+                    let diff = descriptorsA[idxA * DESC_DIM + k] - tileB[i * DESC_DIM + k];
+                    distSq += diff * diff;
+                }
+                if (distSq < bestDistSq) {
+                    secondDistSq = bestDistSq;
+                    bestDistSq = distSq;
+                    bestIdx = i32(tileStart + i);
+                } else if (distSq < secondDistSq) {
+                    secondDistSq = distSq;
+                }
+            }
+        }
+        workgroupBarrier();
+    }
+
+    if (active) {
+        results[idxA].bestIdx = bestIdx;
+        results[idxA].bestDistSq = bestDistSq;
+        results[idxA].secondDistSq = secondDistSq;
+    }
+}